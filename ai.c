@@ -0,0 +1,576 @@
+#define _POSIX_C_SOURCE 200809L // getpid, mkdir
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "ai.h"
+
+#define CYCLE_MAGIC "SNKC"  // Cycle cache files: magic, int height, int width, then a
+                            // direction byte per pit cell, row by row
+#define CYCLE_TAIL_MARGIN 3 // Cycle cells a shortcut keeps clear ahead of the tail
+
+/*
+ * Functionality: Returns true if moving the head one step in dir would not hit a wall or body.
+ */
+bool is_safe_move(const GameState *g, Direction dir) {
+    Point p = *snake_segment(g, 0);
+    switch (dir) {
+        case UP:    p.y--; break;
+        case DOWN:  p.y++; break;
+        case LEFT:  p.x--; break;
+        case RIGHT: p.x++; break;
+    }
+    if (p.x <= 0 || p.x > g->pit_width || p.y <= 0 || p.y > g->pit_height) {
+        return false;
+    }
+    // The tail cell frees up this tick unless the snake is about to eat
+    Point *tail = snake_segment(g, g->snake.length - 1);
+    if (p.x == tail->x && p.y == tail->y && !(p.x == g->food.x && p.y == g->food.y)) {
+        return true;
+    }
+    return !is_snake_position(g, p.x, p.y);
+}
+
+/*
+ * Functionality: Picks a direction toward the food, falling back to any safe move.
+ */
+Direction greedy_direction(const GameState *g) {
+    Point head = *snake_segment(g, 0);
+    Direction wanted[4];
+    int n = 0;
+
+    if (g->food.x > head.x) wanted[n++] = RIGHT;
+    if (g->food.x < head.x) wanted[n++] = LEFT;
+    if (g->food.y > head.y) wanted[n++] = DOWN;
+    if (g->food.y < head.y) wanted[n++] = UP;
+    for (int i = 0; i < n; i++) {
+        if (is_safe_move(g, wanted[i])) return wanted[i];
+    }
+
+    if (is_safe_move(g, g->snake.dir)) return g->snake.dir;
+    for (int d = UP; d <= RIGHT; d++) {
+        if (is_safe_move(g, (Direction)d)) return (Direction)d;
+    }
+    return g->snake.dir; // Boxed in
+}
+
+/*
+ * Functionality: Allocates search buffers for a pit_height x pit_width pit. One Pathfinder
+ * serves any number of games of that size, one at a time. Returns false if out of memory.
+ */
+bool pathfinder_init(Pathfinder *pf, int pit_height, int pit_width) {
+    memset(pf, 0, sizeof(*pf));
+    pf->pit_height = pit_height;
+    pf->pit_width = pit_width;
+    pf->grid_stride = pit_width + 2;
+    size_t grid_size = (size_t)(pit_height + 2) * pf->grid_stride;
+    size_t cells = (size_t)pit_height * pit_width;
+
+    pf->queue = (int *)malloc((2 * cells + 1) * sizeof(int));
+    pf->parent = (int *)malloc(grid_size * sizeof(int));
+    pf->cost = (int *)malloc(grid_size * sizeof(int));
+    pf->visited = (uint32_t *)calloc(grid_size, sizeof(uint32_t));
+    pf->blocked = (uint32_t *)calloc(grid_size, sizeof(uint32_t));
+    pf->path = (int *)malloc(cells * sizeof(int));
+    if (!pf->queue || !pf->parent || !pf->cost || !pf->visited || !pf->blocked || !pf->path) {
+        pathfinder_free(pf);
+        return false;
+    }
+    pathfinder_reset(pf);
+    return true;
+}
+
+/*
+ * Functionality: Forgets the cached route; call before reusing pf for a new game.
+ */
+void pathfinder_reset(Pathfinder *pf) {
+    pf->chase_ticks = 0;
+    pf->path_len = 0;
+    pf->path_pos = 0;
+    pf->path_food.x = -1;
+    pf->path_food.y = -1;
+}
+
+/*
+ * Functionality: Releases the search buffers.
+ */
+void pathfinder_free(Pathfinder *pf) {
+    free(pf->queue);
+    free(pf->parent);
+    free(pf->cost);
+    free(pf->visited);
+    free(pf->blocked);
+    free(pf->path);
+    memset(pf, 0, sizeof(*pf));
+}
+
+/*
+ * Functionality: Returns a fresh generation stamp. On the rare wrap-around the stamp arrays
+ * are cleared so no stale stamp can match.
+ */
+static uint32_t next_generation(Pathfinder *pf) {
+    if (++pf->generation == 0) {
+        size_t grid_size = (size_t)(pf->pit_height + 2) * pf->grid_stride;
+        memset(pf->visited, 0, grid_size * sizeof(uint32_t));
+        memset(pf->blocked, 0, grid_size * sizeof(uint32_t));
+        pf->generation = 1;
+    }
+    return pf->generation;
+}
+
+/*
+ * Functionality: Returns the Manhattan distance between grid cells a and b.
+ */
+static inline int cell_distance(int a, int b, int stride) {
+    return abs(a % stride - b % stride) + abs(a / stride - b / stride);
+}
+
+/*
+ * Functionality: Shortest-route search from grid cell start to target over the pit: A* with
+ * the Manhattan distance as its estimate, so an open pit costs about one cell per step of
+ * the route instead of a flood of every cell that close to the start. Each step changes
+ * the estimate by one, so a cell's route-plus-estimate is either the current best, and the
+ * cell goes to the front of pf->queue to be expanded next, or two more, and it goes to the
+ * back. Cells are passable unless they are borders or body: the real body from the
+ * occupancy grid, or with body_stamp set, the cells stamped with it in pf->blocked. The
+ * target itself is always passable. Fills pf->parent and returns true if the target was
+ * reached.
+ */
+static bool search(Pathfinder *pf, const GameState *g, int start, int target, uint32_t body_stamp) {
+    uint32_t stamp = next_generation(pf);
+    int stride = pf->grid_stride;
+    int offsets[4] = { -stride, stride, -1, 1 };
+    // Each cell joins the front at most once and the back at most once, so starting in the
+    // middle of the 2 * cells + 1 slots neither end can run off the array
+    int head = pf->pit_height * pf->pit_width, tail = head;
+
+    pf->visited[start] = stamp;
+    pf->cost[start] = 0;
+    pf->queue[tail++] = start;
+    while (head < tail) {
+        int cell = pf->queue[head++];
+        int cost = pf->cost[cell] + 1;
+        int estimate = cell_distance(cell, target, stride);
+        for (int k = 0; k < 4; k++) {
+            int next = cell + offsets[k];
+            if (next == target) {
+                pf->parent[next] = cell;
+                return true;
+            }
+            // Skip cells already reached at least as cheaply; a cell that was queued again
+            // more cheaply is expanded twice, the second time finding nothing new
+            if (pf->visited[next] == stamp && pf->cost[next] <= cost) continue;
+            // Border cells sit in row/column 0 and pit_height + 1 / pit_width + 1
+            int x = next % stride, y = next / stride;
+            if (x < 1 || x > pf->pit_width || y < 1 || y > pf->pit_height) continue;
+            if (body_stamp ? pf->blocked[next] == body_stamp : g->occupancy[next] != 0) continue;
+            pf->visited[next] = stamp;
+            pf->cost[next] = cost;
+            pf->parent[next] = cell;
+            if (cell_distance(next, target, stride) < estimate) {
+                pf->queue[--head] = next;
+            } else {
+                pf->queue[tail++] = next;
+            }
+        }
+    }
+    return false;
+}
+
+/*
+ * Functionality: Writes the route the last search found from start to target into pf->path
+ * (first step first) and returns its length.
+ */
+static int trace_path(Pathfinder *pf, int start, int target) {
+    int len = 0;
+    for (int cell = target; cell != start; cell = pf->parent[cell]) {
+        len++;
+    }
+    int i = len;
+    for (int cell = target; cell != start; cell = pf->parent[cell]) {
+        pf->path[--i] = cell;
+    }
+    return len;
+}
+
+/*
+ * Functionality: Safety check for a route of len cells ending on the food: places a virtual
+ * snake where the real one would be right after eating and checks its head can still reach
+ * its tail, so taking the food never seals the snake in.
+ */
+static bool route_is_safe(Pathfinder *pf, const GameState *g, int len) {
+    int length = g->snake.length;
+    uint32_t body = next_generation(pf);
+
+    // After eating, the body is the route (food first) followed by the oldest
+    // segments that still fit in length + 1
+    int route_cells = len < length + 1 ? len : length + 1;
+    for (int i = len - route_cells; i < len; i++) {
+        pf->blocked[pf->path[i]] = body;
+    }
+    int tail_cell;
+    if (len <= length) {
+        for (int i = 0; i <= length - len; i++) {
+            Point *seg = snake_segment(g, i);
+            pf->blocked[grid_cell(g, seg->x, seg->y)] = body;
+        }
+        Point *tail = snake_segment(g, length - len);
+        tail_cell = grid_cell(g, tail->x, tail->y);
+    } else {
+        tail_cell = pf->path[len - 1 - length];
+    }
+    return search(pf, g, pf->path[len - 1], tail_cell, body);
+}
+
+/*
+ * Functionality: Returns the direction of the step from grid cell from to its neighbor to.
+ */
+static Direction cell_direction(int from, int to) {
+    int delta = to - from;
+    if (delta == 1) return RIGHT;
+    if (delta == -1) return LEFT;
+    return delta > 0 ? DOWN : UP;
+}
+
+/*
+ * Functionality: BFS autopilot. Follows the shortest route to the food, searched once per
+ * food and reused while the food stays put (the route stays clear: the body only ever
+ * grows along it). A route is only taken if the snake could still reach its own tail
+ * after eating; otherwise the snake chases its tail to buy time, and as a last resort
+ * takes any safe move. Deterministic, so a chase that never ends is cut short after
+ * pit-size ticks.
+ */
+Direction path_direction(Pathfinder *pf, const GameState *g) {
+    Point head = *snake_segment(g, 0);
+    int head_cell = grid_cell(g, head.x, head.y);
+
+    if (pf->path_pos < pf->path_len &&
+        (pf->path_food.x != g->food.x || pf->path_food.y != g->food.y)) {
+        pf->path_len = 0; // The food moved: the route is stale
+    }
+    if (pf->path_pos >= pf->path_len && g->food.x > 0 &&
+        (pf->path_food.x != g->food.x || pf->path_food.y != g->food.y)) {
+        // New food: search once, and only keep routes that pass the safety check
+        int food_cell = grid_cell(g, g->food.x, g->food.y);
+        pf->path_len = 0;
+        pf->path_pos = 0;
+        if (search(pf, g, head_cell, food_cell, 0)) {
+            int len = trace_path(pf, head_cell, food_cell);
+            // A chase that has lasted a whole board's worth of ticks is probably repeating
+            // itself; risk the unchecked route rather than loop forever
+            if (pf->chase_ticks > pf->pit_height * pf->pit_width || route_is_safe(pf, g, len)) {
+                pf->path_len = len;
+                pf->path_food = g->food;
+                pf->chase_ticks = 0;
+            }
+        }
+    }
+
+    if (pf->path_pos < pf->path_len) {
+        Direction dir = cell_direction(head_cell, pf->path[pf->path_pos]);
+        if (is_safe_move(g, dir)) {
+            pf->path_pos++;
+            return dir;
+        }
+        pf->path_len = 0;
+    }
+
+    // No safe route to the food yet: follow the tail, which keeps space open, and retry
+    // the food search next tick
+    pf->path_food.x = -1;
+    pf->path_food.y = -1;
+    pf->path_len = 0;
+    pf->chase_ticks++;
+    Point *tail = snake_segment(g, g->snake.length - 1);
+    int tail_cell = grid_cell(g, tail->x, tail->y);
+    if (g->snake.length > 1 && search(pf, g, head_cell, tail_cell, 0)) {
+        int len = trace_path(pf, head_cell, tail_cell);
+        Direction dir = cell_direction(head_cell, pf->path[0]);
+        // Stepping onto the tail is only safe when it moves away this tick
+        if (len > 1 || is_safe_move(g, dir)) return dir;
+    }
+    return greedy_direction(g);
+}
+
+/*
+ * Functionality: Writes a Hamiltonian cycle of an h x w pit into order (h * w cells).
+ * Row 1 runs right, rows 2..h boustrophedon over columns 2..w, and column 1 leads
+ * back up. Needs h even; odd-h pits with even w are handled by transposing.
+ * Returns false if both dimensions are odd (no cycle exists).
+ */
+bool hamiltonian_cycle(int h, int w, Point *order) {
+    if (h % 2 != 0) {
+        if (w % 2 != 0) return false;
+        if (!hamiltonian_cycle(w, h, order)) return false;
+        for (int i = 0; i < h * w; i++) {
+            int t = order[i].x;
+            order[i].x = order[i].y;
+            order[i].y = t;
+        }
+        return true;
+    }
+
+    int n = 0;
+    for (int x = 1; x <= w; x++) {
+        order[n++] = (Point){ x, 1 };
+    }
+    for (int y = 2; y <= h; y++) {
+        if (y % 2 == 0) {
+            for (int x = w; x >= 2; x--) order[n++] = (Point){ x, y };
+        } else {
+            for (int x = 2; x <= w; x++) order[n++] = (Point){ x, y };
+        }
+    }
+    for (int y = h; y >= 2; y--) {
+        order[n++] = (Point){ 1, y };
+    }
+    return true;
+}
+
+/*
+ * Functionality: Returns the direction of the one-cell step from a to b.
+ */
+static Direction point_direction(Point a, Point b) {
+    if (b.x > a.x) return RIGHT;
+    if (b.x < a.x) return LEFT;
+    if (b.y > a.y) return DOWN;
+    return UP;
+}
+
+/*
+ * Functionality: Returns the grid cell one step from cell in direction dir.
+ */
+static inline int step_cell(int cell, Direction dir, int stride) {
+    return cell + (dir == RIGHT) - (dir == LEFT) + ((dir == DOWN) - (dir == UP)) * stride;
+}
+
+/*
+ * Functionality: Fills t->order by walking t->next from cell (1, 1). Returns false unless the
+ * walk visits every pit cell exactly once and comes back, so a corrupt cache is never used.
+ */
+static bool index_cycle(CycleTable *t) {
+    int stride = t->grid_stride, cells = t->pit_height * t->pit_width;
+    for (int y = 1; y <= t->pit_height; y++) {
+        for (int x = 1; x <= t->pit_width; x++) {
+            t->order[y * stride + x] = -1;
+        }
+    }
+
+    int start = stride + 1, cell = start;
+    for (int i = 0; i < cells; i++) {
+        int x = cell % stride, y = cell / stride;
+        if (x < 1 || x > t->pit_width || y < 1 || y > t->pit_height || t->order[cell] != -1 ||
+            t->next[cell] > RIGHT) {
+            return false;
+        }
+        t->order[cell] = i;
+        cell = step_cell(cell, (Direction)t->next[cell], stride);
+    }
+    return cell == start;
+}
+
+/*
+ * Functionality: Formats the cache file path for an h x w cycle into buf.
+ */
+static void cycle_cache_path(char *buf, size_t size, const char *cache_dir, int h, int w) {
+    snprintf(buf, size, "%s/cycle-%dx%d.bin", cache_dir, h, w);
+}
+
+/*
+ * Functionality: Reads the cached next-direction table for t's size into t->next. Returns
+ * false if there is no usable cache file.
+ */
+static bool load_cycle(CycleTable *t, const char *cache_dir) {
+    char path[PATH_MAX];
+    cycle_cache_path(path, sizeof(path), cache_dir, t->pit_height, t->pit_width);
+    FILE *f = fopen(path, "rb");
+    if (!f) return false;
+
+    char magic[4];
+    int dims[2];
+    bool ok = fread(magic, sizeof(magic), 1, f) == 1 && memcmp(magic, CYCLE_MAGIC, 4) == 0 &&
+              fread(dims, sizeof(dims), 1, f) == 1 && dims[0] == t->pit_height &&
+              dims[1] == t->pit_width;
+    for (int y = 1; ok && y <= t->pit_height; y++) {
+        ok = fread(t->next + y * t->grid_stride + 1, (size_t)t->pit_width, 1, f) == 1;
+    }
+    fclose(f);
+    return ok && index_cycle(t);
+}
+
+/*
+ * Functionality: Creates dir and any missing parents. Returns false on failure.
+ */
+static bool make_dirs(const char *dir) {
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s", dir);
+    for (char *p = path + 1; *p; p++) {
+        if (*p != '/') continue;
+        *p = '\0';
+        if (mkdir(path, 0755) != 0 && errno != EEXIST) return false;
+        *p = '/';
+    }
+    return mkdir(path, 0755) == 0 || errno == EEXIST;
+}
+
+/*
+ * Functionality: Writes t's next-direction table to the cache, via a temporary file renamed
+ * into place so concurrent runs never read a partial file. Failures are ignored: the
+ * table just gets rebuilt next time.
+ */
+static void save_cycle(const CycleTable *t, const char *cache_dir) {
+    char path[PATH_MAX], tmp[PATH_MAX + 32];
+    if (!make_dirs(cache_dir)) return;
+    cycle_cache_path(path, sizeof(path), cache_dir, t->pit_height, t->pit_width);
+    snprintf(tmp, sizeof(tmp), "%s.%ld.tmp", path, (long)getpid());
+
+    FILE *f = fopen(tmp, "wb");
+    if (!f) return;
+    int dims[2] = { t->pit_height, t->pit_width };
+    bool ok = fwrite(CYCLE_MAGIC, 4, 1, f) == 1 && fwrite(dims, sizeof(dims), 1, f) == 1;
+    for (int y = 1; ok && y <= t->pit_height; y++) {
+        ok = fwrite(t->next + y * t->grid_stride + 1, (size_t)t->pit_width, 1, f) == 1;
+    }
+    ok = fclose(f) == 0 && ok;
+    if (!ok || rename(tmp, path) != 0) remove(tmp);
+}
+
+/*
+ * Functionality: Returns the directory cycle tables are cached in: $SNAKE_CACHE_DIR, else
+ * ~/.cache/snake, or NULL (no caching) without a home directory.
+ */
+const char *default_cache_dir() {
+    static char dir[PATH_MAX];
+    const char *env = getenv("SNAKE_CACHE_DIR");
+    if (env && *env) return env;
+    const char *home = getenv("HOME");
+    if (!home || !*home) return NULL;
+    snprintf(dir, sizeof(dir), "%s/.cache/snake", home);
+    return dir;
+}
+
+/*
+ * Functionality: Prepares the cycle table for a pit_height x pit_width pit, loading it from
+ * cache_dir when cached there and otherwise building it (and caching it, unless cache_dir
+ * is NULL). Returns false if out of memory or no cycle exists (both sides odd).
+ */
+bool cycle_table_init(CycleTable *t, int pit_height, int pit_width, const char *cache_dir) {
+    memset(t, 0, sizeof(*t));
+    t->pit_height = pit_height;
+    t->pit_width = pit_width;
+    t->grid_stride = pit_width + 2;
+    size_t grid_size = (size_t)(pit_height + 2) * t->grid_stride;
+    int cells = pit_height * pit_width;
+    t->next = (unsigned char *)calloc(grid_size, 1);
+    t->order = (int *)calloc(grid_size, sizeof(int));
+    if (!t->next || !t->order) {
+        cycle_table_free(t);
+        return false;
+    }
+    if (cache_dir && load_cycle(t, cache_dir)) return true;
+
+    Point *cycle = (Point *)malloc((size_t)cells * sizeof(Point));
+    bool ok = cycle && hamiltonian_cycle(pit_height, pit_width, cycle);
+    for (int i = 0; ok && i < cells; i++) {
+        t->next[cycle[i].y * t->grid_stride + cycle[i].x] =
+            (unsigned char)point_direction(cycle[i], cycle[(i + 1) % cells]);
+    }
+    free(cycle);
+    ok = ok && index_cycle(t);
+    if (!ok) {
+        cycle_table_free(t);
+        return false;
+    }
+    if (cache_dir) save_cycle(t, cache_dir);
+    return true;
+}
+
+/*
+ * Functionality: Releases a cycle table.
+ */
+void cycle_table_free(CycleTable *t) {
+    free(t->next);
+    free(t->order);
+    memset(t, 0, sizeof(*t));
+}
+
+/*
+ * Functionality: Hamiltonian-cycle autopilot: one table lookup per tick, so it never loses.
+ * The body always occupies cycle positions between the tail and the head, in order, so
+ * the head may jump ahead to any free neighbor that stays short of the tail (with a few
+ * cells to spare for growth) without breaking that order. It takes the jump that gets
+ * closest to the food without passing it, and follows the cycle otherwise. The starting
+ * snake need not lie along the cycle; until it does, a blocked cycle step is replaced by
+ * the free neighbor furthest along the cycle.
+ */
+Direction cycle_direction(const CycleTable *t, const GameState *g) {
+    int cells = t->pit_height * t->pit_width, stride = t->grid_stride;
+    Point head = *snake_segment(g, 0), tail = *snake_segment(g, g->snake.length - 1);
+    int head_cell = grid_cell(g, head.x, head.y), tail_cell = grid_cell(g, tail.x, tail.y);
+    int head_pos = t->order[head_cell];
+    Direction best = (Direction)t->next[head_cell];
+    int ahead = step_cell(head_cell, best, stride);
+    bool blocked = g->occupancy[ahead] && ahead != tail_cell;
+
+    // Only shortcut while the body leaves room; a long snake just follows the cycle
+    if (!blocked && (g->food.x <= 0 || g->snake.length > cells / 2)) return best;
+
+    int to_tail = (t->order[tail_cell] - head_pos + cells) % cells;
+    int to_food = 0;
+    if (g->food.x > 0) to_food = (t->order[grid_cell(g, g->food.x, g->food.y)] - head_pos + cells) % cells;
+    int best_jump = blocked ? 0 : 1;
+    for (int d = UP; d <= RIGHT; d++) {
+        int next = step_cell(head_cell, (Direction)d, stride);
+        int x = next % stride, y = next / stride;
+        if (x < 1 || x > t->pit_width || y < 1 || y > t->pit_height || g->occupancy[next]) continue;
+        int jump = (t->order[next] - head_pos + cells) % cells;
+        if (jump > best_jump && (blocked || (jump <= to_food && jump < to_tail - CYCLE_TAIL_MARGIN))) {
+            best = (Direction)d;
+            best_jump = jump;
+        }
+    }
+    return best;
+}
+
+/*
+ * Functionality: Parses a policy name ("greedy", "bfs", "cycle" or "lookahead"). Returns false
+ * if unknown.
+ */
+bool parse_policy(const char *name, Policy *policy) {
+    if (strcmp(name, "greedy") == 0) {
+        *policy = POLICY_GREEDY;
+    } else if (strcmp(name, "bfs") == 0) {
+        *policy = POLICY_BFS;
+    } else if (strcmp(name, "cycle") == 0) {
+        *policy = POLICY_CYCLE;
+    } else if (strcmp(name, "lookahead") == 0) {
+        *policy = POLICY_LOOKAHEAD;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Functionality: Returns the move the given policy picks for g. pf (for POLICY_BFS), cycle
+ * (for POLICY_CYCLE) and la (for POLICY_LOOKAHEAD) must be set up for g's pit size when that
+ * policy is used.
+ */
+Direction policy_direction(Policy policy, Pathfinder *pf, const CycleTable *cycle, Lookahead *la,
+                           const GameState *g) {
+    switch (policy) {
+        case POLICY_BFS:
+            return path_direction(pf, g);
+        case POLICY_CYCLE:
+            return cycle_direction(cycle, g);
+        case POLICY_LOOKAHEAD:
+            return lookahead_direction(la, g);
+        case POLICY_GREEDY:
+        default:
+            return greedy_direction(g);
+    }
+}
@@ -0,0 +1,68 @@
+#ifndef AI_H
+#define AI_H
+
+#include "game.h"
+#include "lookahead.h"
+
+/*
+ * Autopilot policies. Each one only reads the GameState it is given, so
+ * every game (and every thread) can run its own bot independently.
+ */
+
+// Autopilot policies selectable on the command line
+typedef enum {
+    POLICY_GREEDY, // Head straight for the food, any safe move otherwise
+    POLICY_BFS,    // Shortest safe route to the food, see path_direction()
+    POLICY_CYCLE,  // Hamiltonian cycle with shortcuts, see cycle_direction()
+    POLICY_LOOKAHEAD // Best of every move sequence a few ticks deep, see lookahead.h
+} Policy;
+
+// Reusable search state for path_direction(). Every buffer is sized once for a pit
+// and shared by all searches; cells count as visited only when stamped with the
+// current search generation, so nothing is cleared between searches.
+typedef struct {
+    int pit_height;
+    int pit_width;
+    int grid_stride;
+    int *queue;          // Search frontier (grid cells), 2 * cells + 1 slots
+    int *parent;         // Cell each visited cell was last reached from
+    int *cost;           // Steps from the start to each visited cell
+    uint32_t *visited;   // Generation of the search that last reached the cell
+    uint32_t *blocked;   // Generation of the safety check that last covered the cell
+    uint32_t generation;
+    int *path;           // Cached route to the food: path[path_pos] is the next cell
+    int path_len;
+    int path_pos;
+    Point path_food;     // Food the cached route leads to
+    int chase_ticks;     // Consecutive ticks spent chasing the tail
+} Pathfinder;
+
+// Precomputed Hamiltonian cycle of a pit: a next-direction lookup table plus each
+// cell's position along the cycle, both indexed by grid cell
+typedef struct {
+    int pit_height;
+    int pit_width;
+    int grid_stride;
+    unsigned char *next; // Direction to the next cell on the cycle
+    int *order;          // Position of each pit cell along the cycle, 0..cells - 1
+} CycleTable;
+
+bool is_safe_move(const GameState *g, Direction dir);
+Direction greedy_direction(const GameState *g);
+
+bool pathfinder_init(Pathfinder *pf, int pit_height, int pit_width);
+void pathfinder_reset(Pathfinder *pf);
+void pathfinder_free(Pathfinder *pf);
+Direction path_direction(Pathfinder *pf, const GameState *g);
+
+bool hamiltonian_cycle(int pit_height, int pit_width, Point *order);
+bool cycle_table_init(CycleTable *t, int pit_height, int pit_width, const char *cache_dir);
+void cycle_table_free(CycleTable *t);
+const char *default_cache_dir();
+Direction cycle_direction(const CycleTable *t, const GameState *g);
+
+bool parse_policy(const char *name, Policy *policy);
+Direction policy_direction(Policy policy, Pathfinder *pf, const CycleTable *cycle, Lookahead *la,
+                           const GameState *g);
+
+#endif
@@ -0,0 +1,43 @@
+#include "alloc.h"
+
+#ifdef SNAKE_ALLOC_DEBUG
+#include <stddef.h>
+
+// glibc's own entry points, which the wrappers below forward to
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *p, size_t size);
+
+static __thread long allocations; // Per thread, so workers only see their own
+
+/*
+ * Functionality: Returns how many allocations the calling thread has made so far.
+ */
+long alloc_mark(void) {
+    return allocations;
+}
+
+/*
+ * Functionality: Counts an allocation that bypasses malloc, such as an arena reservation.
+ */
+void alloc_note(void) {
+    allocations++;
+}
+
+// These replace the C library's malloc family for the whole process, so allocations made
+// inside libc or ncurses on a tick are caught as well as our own
+void *malloc(size_t size) {
+    allocations++;
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+    allocations++;
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *p, size_t size) {
+    allocations++;
+    return __libc_realloc(p, size);
+}
+#endif
@@ -0,0 +1,37 @@
+#ifndef ALLOC_H
+#define ALLOC_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+ * Allocation accounting for the tick loops. Every buffer a game, pathfinder,
+ * cycle table or room needs is carved from an arena or sized up front when it
+ * is created, and reused across games and restarts, so a running tick never
+ * allocates. Building with -DSNAKE_ALLOC_DEBUG (make ALLOC_DEBUG=1) makes
+ * that checkable: malloc, calloc and realloc are wrapped to count calls per
+ * thread, arena reservations count too, and a tick loop takes alloc_mark()
+ * before it starts and calls alloc_check() after each tick, which aborts if
+ * anything on that thread allocated in between. In normal builds both
+ * compile to nothing.
+ */
+
+#ifdef SNAKE_ALLOC_DEBUG
+long alloc_mark(void);
+void alloc_note(void);
+
+/*
+ * Functionality: Aborts, naming the loop, if the calling thread has allocated since mark.
+ */
+static inline void alloc_check(long mark, const char *where) {
+    if (alloc_mark() == mark) return;
+    fprintf(stderr, "%s: %ld allocation(s) in the tick loop\n", where, alloc_mark() - mark);
+    abort();
+}
+#else
+static inline long alloc_mark(void) { return 0; }
+static inline void alloc_note(void) {}
+static inline void alloc_check(long mark, const char *where) { (void)mark; (void)where; }
+#endif
+
+#endif
@@ -0,0 +1,533 @@
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "ansi.h"
+
+#define CELL_WORST_BYTES 22 // Absolute move (14) + color change (7) + glyph (1)
+#define FRAME_SLACK_BYTES 64 // Clear and cursor show/hide sequences
+#define MAX_REPRINT 3        // Cells reprinted at most instead of a cursor move
+
+// Look of each AnsiColor, mirroring the ncurses color pairs
+static const struct {
+    bool bold;
+    char fg; // SGR foreground digit, '9' for the terminal default
+} color_style[ANSI_COLOR_COUNT] = {
+    { false, '9' }, // ANSI_PLAIN
+    { true, '2' },  // ANSI_HEAD: bold green
+    { false, '2' }, // ANSI_BODY: green
+    { true, '1' },  // ANSI_FOOD: bold red
+    { false, '6' }, // ANSI_BORDER: cyan
+    { false, '3' }, // ANSI_TEXT: yellow
+};
+
+/*
+ * Functionality: Writes out everything buffered so far, retrying short writes. Returns
+ * false on a write error; the buffer is emptied either way.
+ */
+static bool write_out(AnsiRenderer *r) {
+    bool ok = true;
+    size_t done = 0;
+    while (done < r->out_len) {
+        ssize_t n = write(r->fd, r->out + done, r->out_len - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            ok = false;
+            break;
+        }
+        done += (size_t)n;
+    }
+    r->bytes += (long long)r->out_len;
+    r->out_len = 0;
+    return ok;
+}
+
+/*
+ * Functionality: Makes room for n more bytes of output. A frame never needs more than the
+ * buffer holds unless cells are redrawn several times in it; then it goes out in parts.
+ */
+static void reserve(AnsiRenderer *r, size_t n) {
+    if (r->out_cap - r->out_len < n) write_out(r);
+}
+
+/*
+ * Functionality: Appends n bytes to the frame.
+ */
+static void emit(AnsiRenderer *r, const char *data, size_t n) {
+    memcpy(r->out + r->out_len, data, n);
+    r->out_len += n;
+}
+
+/*
+ * Functionality: Formats value in decimal into out. Returns the digit count.
+ */
+static size_t put_uint(char *out, int value) {
+    char digits[12];
+    size_t n = 0;
+    do {
+        digits[n++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+    for (size_t i = 0; i < n; i++) {
+        out[i] = digits[n - 1 - i];
+    }
+    return n;
+}
+
+/*
+ * Functionality: Formats a CSI sequence with an optional count (omitted when 1) and a final
+ * letter into out. Returns its length.
+ */
+static size_t put_csi(char *out, int count, char final) {
+    size_t n = 0;
+    out[n++] = '\x1b';
+    out[n++] = '[';
+    if (count != 1) n += put_uint(out + n, count);
+    out[n++] = final;
+    return n;
+}
+
+/*
+ * Functionality: Formats the absolute move to (row, col) into out, leaving out the 1s the
+ * terminal defaults to. Returns its length.
+ */
+static size_t put_cup(char *out, int row, int col) {
+    size_t n = 0;
+    out[n++] = '\x1b';
+    out[n++] = '[';
+    if (row > 0 || col > 0) n += put_uint(out + n, row + 1);
+    if (col > 0) {
+        out[n++] = ';';
+        n += put_uint(out + n, col + 1);
+    }
+    out[n++] = 'H';
+    return n;
+}
+
+/*
+ * Functionality: Formats the shortest relative way from the cursor to (row, col) into out:
+ * a carriage return or sideways move plus an up or down move, or reprinting the few cells
+ * in between when that is shorter. Returns its length. The cursor must be known.
+ */
+static size_t put_relative(const AnsiRenderer *r, char *out, int row, int col) {
+    int dr = row - r->cursor_row, dc = col - r->cursor_col;
+    size_t n = 0;
+    if (col == 0 && dc != 0) {
+        out[n++] = '\r';
+    } else if (dc > 0) {
+        n += put_csi(out + n, dc, 'C');
+    } else if (dc < 0) {
+        n += put_csi(out + n, -dc, 'D');
+    }
+    if (dr > 0) {
+        n += put_csi(out + n, dr, 'B');
+    } else if (dr < 0) {
+        n += put_csi(out + n, -dr, 'A');
+    }
+
+    if (dr == 0 && dc > 0 && dc <= MAX_REPRINT && (size_t)dc < n) {
+        // Cells already on screen cost a byte each to reprint, if no color change is needed
+        const char *glyphs = r->glyphs + (size_t)row * r->cols + r->cursor_col;
+        const unsigned char *colors = r->colors + (size_t)row * r->cols + r->cursor_col;
+        bool reprint = true;
+        for (int i = 0; i < dc && reprint; i++) {
+            reprint = glyphs[i] == ' ' || (glyphs[i] != 0 && colors[i] == r->color);
+        }
+        if (reprint) {
+            memcpy(out, glyphs, (size_t)dc);
+            return (size_t)dc;
+        }
+    }
+    return n;
+}
+
+/*
+ * Functionality: Moves the terminal cursor to (row, col) by the shortest sequence.
+ */
+static void move_to(AnsiRenderer *r, int row, int col) {
+    if (r->cursor_row == row && r->cursor_col == col) return;
+    char absolute[16], relative[24];
+    size_t best = put_cup(absolute, row, col);
+    const char *seq = absolute;
+    if (r->cursor_row >= 0 && r->cursor_col >= 0) {
+        size_t n = put_relative(r, relative, row, col);
+        if (n < best) {
+            best = n;
+            seq = relative;
+        }
+    }
+    emit(r, seq, best);
+    r->cursor_row = row;
+    r->cursor_col = col;
+}
+
+/*
+ * Functionality: Switches the terminal to color by the shorter of changing just what
+ * differs from the current color (bold and/or foreground) or a reset plus the new color.
+ */
+static void set_color(AnsiRenderer *r, AnsiColor color) {
+    char reset[16], change[16];
+    size_t n = 0, m = 0;
+    bool bold = color_style[color].bold;
+    char fg = color_style[color].fg;
+
+    memcpy(reset, "\x1b[0", 3);
+    n = 3;
+    if (bold) {
+        memcpy(reset + n, ";1", 2);
+        n += 2;
+    }
+    if (fg != '9') {
+        reset[n++] = ';';
+        reset[n++] = '3';
+        reset[n++] = fg;
+    }
+    reset[n++] = 'm';
+
+    const char *seq = reset;
+    if (r->color >= 0) {
+        memcpy(change, "\x1b[", 2);
+        m = 2;
+        if (bold != color_style[r->color].bold) {
+            memcpy(change + m, bold ? "1" : "22", bold ? 1 : 2);
+            m += bold ? 1 : 2;
+        }
+        if (fg != color_style[r->color].fg) {
+            if (m > 2) change[m++] = ';';
+            change[m++] = '3';
+            change[m++] = fg;
+        }
+        change[m++] = 'm';
+        if (m < n) {
+            seq = change;
+            n = m;
+        }
+    }
+    emit(r, seq, n);
+    r->color = (int)color;
+}
+
+/*
+ * Functionality: Sets up renderer r writing to fd (-1 when frames are taken with
+ * ansi_take_frame() instead) for a rows x cols terminal showing a pit_height x pit_width
+ * pit, with every buffer allocated up front. The terminal is left alone until the first
+ * keyframe. Returns false if the terminal is too small or out of memory.
+ */
+bool ansi_open(AnsiRenderer *r, int fd, int rows, int cols, int pit_height, int pit_width) {
+    memset(r, 0, sizeof(*r));
+    if (rows < 2 || cols < 1) return false;
+    r->fd = fd;
+    r->rows = rows;
+    r->cols = cols;
+    r->cursor_row = r->cursor_col = r->color = -1;
+
+    int grid_h = pit_height + 2, grid_w = pit_width + 2;
+    r->view_height = rows - 1 < grid_h ? rows - 1 : grid_h;
+    r->view_width = cols < grid_w ? cols : grid_w;
+
+    size_t cells = (size_t)rows * cols;
+    r->glyphs = (char *)calloc(cells, 1); // 0: not known to be on screen
+    r->colors = (unsigned char *)calloc(cells, 1);
+    r->out_cap = cells * CELL_WORST_BYTES + FRAME_SLACK_BYTES;
+    r->out = (char *)malloc(r->out_cap);
+    if (!r->glyphs || !r->colors || !r->out) {
+        ansi_close(r);
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Functionality: Puts the terminal back (default color, visible cursor, on the line below
+ * the screen) and releases the buffers.
+ */
+void ansi_close(AnsiRenderer *r) {
+    if (r->out && r->fd >= 0 && r->cursor_row >= 0) {
+        reserve(r, FRAME_SLACK_BYTES);
+        move_to(r, r->rows - 1, 0);
+        static const char restore[] = "\x1b[0m\x1b[?25h\r\n";
+        emit(r, restore, sizeof(restore) - 1);
+        write_out(r);
+    }
+    free(r->glyphs);
+    free(r->colors);
+    free(r->out);
+    r->glyphs = NULL;
+    r->colors = NULL;
+    r->out = NULL;
+}
+
+/*
+ * Functionality: Starts a frame that assumes nothing about the cursor position or color,
+ * so it applies after any earlier frame: its first move is absolute and its first color a
+ * full one. Costs a few bytes a frame; used where frames go to many terminals.
+ */
+void ansi_begin_frame(AnsiRenderer *r) {
+    r->cursor_row = r->cursor_col = r->color = -1;
+}
+
+/*
+ * Functionality: Moves the frame built so far into out (at most cap bytes) instead of
+ * writing it, counting it as sent. Returns its size.
+ */
+size_t ansi_take_frame(AnsiRenderer *r, char *out, size_t cap) {
+    size_t len = r->out_len < cap ? r->out_len : cap;
+    memcpy(out, r->out, len);
+    r->out_len = 0;
+    if (len > 0) {
+        r->frames++;
+        r->bytes += (long long)len;
+    }
+    return len;
+}
+
+/*
+ * Functionality: Draws glyph in color at screen cell (row, col), unless the terminal shows
+ * it already. Blanks are drawn in the current color, whatever color is asked for.
+ */
+void ansi_put(AnsiRenderer *r, int row, int col, char glyph, AnsiColor color) {
+    if (row < 0 || row >= r->rows || col < 0 || col >= r->cols) return;
+    size_t cell = (size_t)row * r->cols + col;
+    if (r->glyphs[cell] == glyph && (glyph == ' ' || r->colors[cell] == color)) return;
+
+    reserve(r, CELL_WORST_BYTES);
+    move_to(r, row, col);
+    if (glyph != ' ' && (int)color != r->color) set_color(r, color);
+    r->out[r->out_len++] = glyph;
+    r->glyphs[cell] = glyph;
+    r->colors[cell] = (unsigned char)r->color;
+
+    // Writing the last column leaves the cursor in a terminal-specific pending-wrap state
+    r->cursor_col = col + 1 < r->cols ? col + 1 : -1;
+}
+
+/*
+ * Functionality: Draws text in color starting at (row, col), clipped to the screen.
+ */
+void ansi_text(AnsiRenderer *r, int row, int col, const char *text, AnsiColor color) {
+    for (; *text && col < r->cols; text++, col++) {
+        ansi_put(r, row, col, *text, color);
+    }
+}
+
+/*
+ * Functionality: Clears the terminal, hides the cursor and forgets the shadow.
+ */
+void ansi_clear(AnsiRenderer *r) {
+    static const char clear[] = "\x1b[0m\x1b[?25l\x1b[H\x1b[2J";
+    reserve(r, sizeof(clear));
+    emit(r, clear, sizeof(clear) - 1);
+    size_t cells = (size_t)r->rows * r->cols;
+    memset(r->glyphs, ' ', cells);
+    memset(r->colors, ANSI_PLAIN, cells);
+    r->cursor_row = r->cursor_col = 0;
+    r->color = ANSI_PLAIN;
+}
+
+/*
+ * Functionality: Sends the frame built since the last call in one write(). Returns false
+ * on a write error.
+ */
+bool ansi_present(AnsiRenderer *r) {
+    if (r->out_len == 0) return true;
+    r->frames++;
+    return write_out(r);
+}
+
+/*
+ * Functionality: Returns the glyph and color for grid cell (x, y) of game g.
+ */
+static char cell_glyph(const GameState *g, int x, int y, AnsiColor *color) {
+    bool top = y == 0, bottom = y == g->pit_height + 1;
+    bool left = x == 0, right = x == g->pit_width + 1;
+    if (top || bottom || left || right) {
+        *color = ANSI_BORDER;
+        return (top || bottom) && (left || right) ? '+' : (top || bottom) ? '-' : '|';
+    }
+    const Point *head = snake_segment(g, 0);
+    if (head->x == x && head->y == y) {
+        *color = ANSI_HEAD;
+        switch (g->snake.dir) {
+            case UP:
+                return '^';
+            case DOWN:
+                return 'v';
+            case LEFT:
+                return '<';
+            case RIGHT:
+            default:
+                return '>';
+        }
+    }
+    if (g->occupancy[grid_cell(g, x, y)]) {
+        *color = ANSI_BODY;
+        return '#';
+    }
+    if (g->food.x == x && g->food.y == y) {
+        *color = ANSI_FOOD;
+        return '*';
+    }
+    *color = ANSI_PLAIN;
+    return ' ';
+}
+
+/*
+ * Functionality: Redraws grid cell p if the view shows it.
+ */
+static void draw_cell(AnsiRenderer *r, const GameState *g, Point p) {
+    int row = p.y - r->view_y, col = p.x - r->view_x;
+    if (row < 0 || row >= r->view_height || col < 0 || col >= r->view_width) return;
+    AnsiColor color;
+    char glyph = cell_glyph(g, p.x, p.y, &color);
+    ansi_put(r, row + 1, col, glyph, color);
+}
+
+/*
+ * Functionality: Redraws every cell of the view. Only cells that differ from the shadow
+ * produce output, so after a scroll this sends what moved, not the whole view.
+ */
+static void draw_view(AnsiRenderer *r, const GameState *g) {
+    for (int row = 0; row < r->view_height; row++) {
+        for (int col = 0; col < r->view_width; col++) {
+            AnsiColor color;
+            char glyph = cell_glyph(g, col + r->view_x, row + r->view_y, &color);
+            ansi_put(r, row + 1, col, glyph, color);
+        }
+    }
+}
+
+/*
+ * Functionality: Draws the length on the HUD row, padded so a shorter number overwrites a
+ * longer one.
+ */
+static void draw_hud(AnsiRenderer *r, const GameState *g) {
+    char line[48];
+    snprintf(line, sizeof(line), "Length: %d/%d      ", g->snake.length, g->snake.max_length);
+    ansi_text(r, 0, 0, line, ANSI_TEXT);
+}
+
+/*
+ * Functionality: Clamps a camera origin so [origin, origin + size) stays on the grid.
+ */
+static int clamp_origin(int origin, int size, int grid_size) {
+    if (origin > grid_size - size) origin = grid_size - size;
+    if (origin < 0) origin = 0;
+    return origin;
+}
+
+/*
+ * Functionality: Keeps the head inside the middle half of the view, as the ncurses camera
+ * does, or centers it when force is set. Returns true if the camera moved.
+ */
+static bool update_camera(AnsiRenderer *r, const GameState *g, bool force) {
+    Point head = *snake_segment(g, 0);
+    int new_y = r->view_y, new_x = r->view_x;
+    int margin_y = r->view_height / 4, margin_x = r->view_width / 4;
+
+    if (force) {
+        new_y = head.y - r->view_height / 2;
+        new_x = head.x - r->view_width / 2;
+    } else {
+        if (head.y < new_y + margin_y) new_y = head.y - margin_y;
+        if (head.y >= new_y + r->view_height - margin_y) new_y = head.y - r->view_height + margin_y + 1;
+        if (head.x < new_x + margin_x) new_x = head.x - margin_x;
+        if (head.x >= new_x + r->view_width - margin_x) new_x = head.x - r->view_width + margin_x + 1;
+    }
+    new_y = clamp_origin(new_y, r->view_height, g->pit_height + 2);
+    new_x = clamp_origin(new_x, r->view_width, g->pit_width + 2);
+
+    if (new_y == r->view_y && new_x == r->view_x) return false;
+    r->view_y = new_y;
+    r->view_x = new_x;
+    return true;
+}
+
+/*
+ * Functionality: Builds a keyframe: clears the terminal and draws the HUD and the whole
+ * view, centered on the head. Send it with ansi_present().
+ */
+void ansi_draw_full_frame(AnsiRenderer *r, const GameState *g) {
+    update_camera(r, g, true);
+    ansi_redraw(r, g);
+}
+
+/*
+ * Functionality: Builds a keyframe without moving the camera, so the screen ends up just
+ * as after the last frame: for a terminal that missed frames to catch up with the others.
+ */
+void ansi_redraw(AnsiRenderer *r, const GameState *g) {
+    ansi_clear(r);
+    draw_view(r, g);
+    draw_hud(r, g);
+}
+
+/*
+ * Functionality: Builds the frame for one move, like draw_changes() in the ncurses
+ * renderer: the old and new head, the old tail, the old and new food and the HUD, or the
+ * whole view when the camera moved. Send it with ansi_present().
+ */
+void ansi_draw_changes(AnsiRenderer *r, const GameState *g, Point old_head, Point old_tail,
+                       int old_length, Point old_food) {
+    if (update_camera(r, g, false)) {
+        draw_view(r, g);
+    } else {
+        draw_cell(r, g, old_tail);
+        draw_cell(r, g, old_head);
+        draw_cell(r, g, *snake_segment(g, 0));
+        if (old_food.x > 0) draw_cell(r, g, old_food);
+        if (g->food.x > 0) draw_cell(r, g, g->food);
+    }
+    if (g->snake.length != old_length) draw_hud(r, g);
+}
+
+/*
+ * Functionality: Returns the glyph and color for grid cell (x, y) of a room: every snake
+ * with its head pointing its way, food and the border.
+ */
+static char room_glyph(const Room *room, int x, int y, AnsiColor *color) {
+    int cell = y * room->grid_stride + x;
+    int owner = room->cell_owner[cell];
+    if (owner == ROOM_WALL) {
+        bool top = y == 0, bottom = y == room->pit_height + 1;
+        bool left = x == 0, right = x == room->pit_width + 1;
+        *color = ANSI_BORDER;
+        return (top || bottom) && (left || right) ? '+' : (top || bottom) ? '-' : '|';
+    }
+    if (owner != 0) {
+        const RoomSnake *s = &room->snakes[owner - 1];
+        const Point *head = room_segment(s, 0);
+        if (head->x == x && head->y == y) {
+            *color = ANSI_HEAD;
+            return "^v<>"[s->snake.dir];
+        }
+        *color = ANSI_BODY;
+        return '#';
+    }
+    if (room->food_pos[cell]) {
+        *color = ANSI_FOOD;
+        return '*';
+    }
+    *color = ANSI_PLAIN;
+    return ' ';
+}
+
+/*
+ * Functionality: Builds a frame of room from the top-left of its pit and the number of
+ * snakes alive. The whole view is redrawn through the shadow, so only cells that changed
+ * since the last frame are sent. Send it with ansi_present() or take it with
+ * ansi_take_frame(); call ansi_clear() first to make it a keyframe.
+ */
+void ansi_draw_room(AnsiRenderer *r, const Room *room) {
+    for (int row = 0; row < r->view_height; row++) {
+        for (int col = 0; col < r->view_width; col++) {
+            AnsiColor color;
+            char glyph = room_glyph(room, col, row, &color);
+            ansi_put(r, row + 1, col, glyph, color);
+        }
+    }
+    char line[48];
+    snprintf(line, sizeof(line), "Snakes: %d      ", room->alive_count);
+    ansi_text(r, 0, 0, line, ANSI_TEXT);
+}
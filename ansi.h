@@ -0,0 +1,72 @@
+#ifndef ANSI_H
+#define ANSI_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "game.h"
+#include "room.h"
+
+/*
+ * Raw ANSI renderer: an alternative to the ncurses one (render.h) for terminals
+ * driven without ncurses, such as spectators at the far end of a pipe or socket,
+ * where every byte of a frame costs bandwidth.
+ *
+ * Each frame is built in one output buffer, sized for the worst case up front
+ * and written with a single write(). A shadow copy of what the terminal shows
+ * keeps frames minimal: a cell is only sent when it changes, the cursor gets
+ * there by whichever of a relative move, a carriage return, reprinting the one
+ * to three cells in between or an absolute move is shortest, and a color
+ * (SGR) sequence is only sent when the color actually changes. Blanks are
+ * drawn in whatever color is current. Glyphs are plain ASCII, one byte each.
+ *
+ * Row 0 is the HUD; the pit view fills the rows below it, with a camera that
+ * follows the head when the pit does not fit. A multiplayer Room can be drawn
+ * too, from the top-left corner of its pit.
+ */
+
+typedef enum {
+    ANSI_PLAIN,
+    ANSI_HEAD,
+    ANSI_BODY,
+    ANSI_FOOD,
+    ANSI_BORDER,
+    ANSI_TEXT,
+    ANSI_COLOR_COUNT
+} AnsiColor;
+
+typedef struct {
+    int fd;              // Where frames are written
+    int rows;            // Screen size in cells
+    int cols;
+    char *glyphs;        // Shadow of the screen: what the terminal shows per cell ...
+    unsigned char *colors; // ... and in which color
+    int cursor_row;      // Terminal cursor, -1 when unknown
+    int cursor_col;
+    int color;           // Current terminal color, -1 when unknown
+    char *out;           // The frame being built, a fixed buffer of out_cap bytes
+    size_t out_len;
+    size_t out_cap;
+    int view_height;     // Pit view size, below the HUD row
+    int view_width;
+    int view_y;          // Grid coords shown at the view's top-left cell
+    int view_x;
+    long frames;         // Frames written so far ...
+    long long bytes;     // ... and their total size
+} AnsiRenderer;
+
+bool ansi_open(AnsiRenderer *r, int fd, int rows, int cols, int pit_height, int pit_width);
+void ansi_close(AnsiRenderer *r);
+void ansi_begin_frame(AnsiRenderer *r);
+size_t ansi_take_frame(AnsiRenderer *r, char *out, size_t cap);
+void ansi_put(AnsiRenderer *r, int row, int col, char glyph, AnsiColor color);
+void ansi_text(AnsiRenderer *r, int row, int col, const char *text, AnsiColor color);
+void ansi_clear(AnsiRenderer *r);
+bool ansi_present(AnsiRenderer *r);
+void ansi_draw_full_frame(AnsiRenderer *r, const GameState *g);
+void ansi_redraw(AnsiRenderer *r, const GameState *g);
+void ansi_draw_changes(AnsiRenderer *r, const GameState *g, Point old_head, Point old_tail,
+                       int old_length, Point old_food);
+void ansi_draw_room(AnsiRenderer *r, const Room *room);
+
+#endif
@@ -0,0 +1,364 @@
+#define _POSIX_C_SOURCE 200809L // ftello, fseeko
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "archive.h"
+
+#define SNAPSHOT_FIXED_SIZE 52 // Snapshot bytes before the RNG state
+
+// Snapshot flag bits
+#define SNAP_GAME_OVER 1
+#define SNAP_VICTORY 2
+#define SNAP_FREE_SET 4
+
+/*
+ * Functionality: Returns the number of bytes a snapshot of g takes.
+ */
+static size_t snapshot_size(const GameState *g) {
+    size_t size = SNAPSHOT_FIXED_SIZE + sizeof(Rng) + 8 + packed_size(g->snake.length);
+    if (g->free_set_ready) size += (size_t)g->free_count * 4;
+    return size;
+}
+
+/*
+ * Functionality: Encodes g, whose body is already packed into body, and the replay reader
+ * position r into out (snapshot_size(g) bytes).
+ */
+static void encode_snapshot(const GameState *g, const PackedBody *body, const ReplayReader *r,
+                            uint8_t *out) {
+    put_le(out, (uint64_t)g->ticks, 8);
+    put_le(out + 8, r->pos, 8);
+    put_le(out + 16, (uint64_t)r->tick, 8);
+    put_le(out + 24, (uint64_t)r->pending_tick, 8);
+    out[32] = r->pending;
+    out[33] = (uint8_t)r->pending_dir;
+    out[34] = (uint8_t)g->snake.dir;
+    out[35] = (g->game_over ? SNAP_GAME_OVER : 0) | (g->victory ? SNAP_VICTORY : 0) |
+              (g->free_set_ready ? SNAP_FREE_SET : 0);
+    put_le(out + 36, (uint32_t)g->food.x, 4);
+    put_le(out + 40, (uint32_t)g->food.y, 4);
+    put_le(out + 44, (uint32_t)g->snake.length, 4);
+    put_le(out + 48, (uint32_t)g->free_count, 4);
+
+    uint8_t *p = out + SNAPSHOT_FIXED_SIZE;
+    memcpy(p, &g->rng, sizeof(Rng));
+    p += sizeof(Rng);
+    put_le(p, (uint32_t)body->head.x, 2);
+    put_le(p + 2, (uint32_t)body->head.y, 2);
+    put_le(p + 4, (uint32_t)body->tail.x, 2);
+    put_le(p + 6, (uint32_t)body->tail.y, 2);
+    packed_write(body, p + 8);
+    p += 8 + packed_size(g->snake.length);
+    if (g->free_set_ready) {
+        for (int i = 0; i < g->free_count; i++, p += 4) {
+            put_le(p, (uint32_t)g->free_cells[i], 4);
+        }
+    }
+}
+
+/*
+ * Functionality: Writes size bytes and advances *offset past them.
+ */
+static bool write_bytes(ArchiveWriter *w, const void *data, size_t size, uint64_t *offset) {
+    if (size && fwrite(data, size, 1, w->file) != 1) return false;
+    *offset += size;
+    return true;
+}
+
+/*
+ * Functionality: Creates an archive at path that snapshots every snapshot_interval ticks.
+ * Games are then added with archive_add() and the file completed by archive_finish().
+ */
+bool archive_create(ArchiveWriter *w, const char *path, int snapshot_interval) {
+    memset(w, 0, sizeof(*w));
+    if (snapshot_interval < 1) return false;
+    w->snapshot_interval = snapshot_interval;
+    if (!packed_init(&w->body, INITIAL_BODY_CAPACITY)) return false;
+    w->file = fopen(path, "wb");
+    if (!w->file) {
+        packed_free(&w->body);
+        return false;
+    }
+
+    // Placeholder header, rewritten once the index offset is known
+    uint8_t header[ARCHIVE_HEADER_SIZE] = {0};
+    return fwrite(header, sizeof(header), 1, w->file) == 1;
+}
+
+/*
+ * Functionality: Appends one game: its replay log, snapshots taken while re-simulating it and
+ * the snapshot offset table. Returns false on a write error or a log that does not replay.
+ */
+bool archive_add(ArchiveWriter *w, const ReplayHeader *h, const uint8_t *entries, size_t size) {
+    if (w->game_count == w->index_capacity) {
+        int capacity = w->index_capacity ? w->index_capacity * 2 : 64;
+        uint8_t *index = (uint8_t *)realloc(w->index, (size_t)capacity * ARCHIVE_INDEX_ENTRY_SIZE);
+        if (!index) return false;
+        w->index = index;
+        w->index_capacity = capacity;
+    }
+
+    off_t start = ftello(w->file);
+    if (start < 0) return false;
+    uint64_t offset = (uint64_t)start;
+    uint64_t replay_offset = offset;
+
+    uint8_t head[REPLAY_HEADER_SIZE];
+    replay_encode_header(h, head);
+    if (!write_bytes(w, head, sizeof(head), &offset) || !write_bytes(w, entries, size, &offset)) {
+        return false;
+    }
+    uint64_t replay_size = offset - replay_offset;
+
+    GameState game;
+    ReplayReader reader;
+    uint64_t *table = NULL;
+    long count = 0, capacity = 0;
+    bool ok = replay_start(&game, h);
+    replay_reader_init(&reader, entries, size);
+
+    for (long t = w->snapshot_interval; ok && t < h->ticks; t += w->snapshot_interval) {
+        // The game cannot end before its recorded final tick unless the log is inconsistent
+        ok = replay_play(&game, &reader, h, t) && game.ticks == t;
+        if (!ok) break;
+
+        size_t snap = snapshot_size(&game);
+        if (snap > w->snapshot_capacity) {
+            uint8_t *buf = (uint8_t *)realloc(w->snapshot, snap);
+            if (!buf) {
+                ok = false;
+                break;
+            }
+            w->snapshot = buf;
+            w->snapshot_capacity = snap;
+        }
+        if (count == capacity) {
+            capacity = capacity ? capacity * 2 : 16;
+            uint64_t *grown = (uint64_t *)realloc(table, (size_t)capacity * sizeof(uint64_t));
+            if (!grown) {
+                ok = false;
+                break;
+            }
+            table = grown;
+        }
+        if (!packed_from_game(&w->body, &game)) {
+            ok = false;
+            break;
+        }
+        table[count++] = offset;
+        encode_snapshot(&game, &w->body, &reader, w->snapshot);
+        ok = write_bytes(w, w->snapshot, snap, &offset);
+    }
+    if (game.snake.body) game_free(&game);
+
+    uint64_t snapshots_offset = offset;
+    for (long k = 0; ok && k < count; k++) {
+        uint8_t buf[8];
+        put_le(buf, table[k], 8);
+        ok = write_bytes(w, buf, sizeof(buf), &offset);
+    }
+    free(table);
+    if (!ok) return false;
+
+    uint8_t *entry = w->index + (size_t)w->game_count * ARCHIVE_INDEX_ENTRY_SIZE;
+    put_le(entry, replay_offset, 8);
+    put_le(entry + 8, replay_size, 8);
+    put_le(entry + 16, snapshots_offset, 8);
+    put_le(entry + 24, (uint64_t)count, 8);
+    w->game_count++;
+    return true;
+}
+
+/*
+ * Functionality: Writes the index and the final header, closes the file and releases the
+ * writer. Returns false if any write failed.
+ */
+bool archive_finish(ArchiveWriter *w) {
+    off_t index_offset = ftello(w->file);
+    bool ok = index_offset >= 0;
+    if (ok && w->game_count > 0) {
+        ok = fwrite(w->index, (size_t)w->game_count * ARCHIVE_INDEX_ENTRY_SIZE, 1, w->file) == 1;
+    }
+
+    uint8_t header[ARCHIVE_HEADER_SIZE] = {0};
+    memcpy(header, ARCHIVE_MAGIC, 4);
+    put_le(header + 4, ARCHIVE_VERSION, 4);
+    put_le(header + 8, (uint32_t)w->game_count, 4);
+    put_le(header + 12, (uint32_t)w->snapshot_interval, 4);
+    put_le(header + 16, sizeof(Rng), 4);
+    put_le(header + 24, (uint64_t)index_offset, 8);
+    ok = ok && fseeko(w->file, 0, SEEK_SET) == 0 && fwrite(header, sizeof(header), 1, w->file) == 1;
+    ok = fclose(w->file) == 0 && ok;
+
+    free(w->index);
+    free(w->snapshot);
+    packed_free(&w->body);
+    memset(w, 0, sizeof(*w));
+    return ok;
+}
+
+/*
+ * Functionality: Returns a pointer to the len bytes at offset, or NULL if they run past the
+ * end of the archive.
+ */
+static const uint8_t *archive_span(const Archive *a, uint64_t offset, uint64_t len) {
+    if (offset > a->size || len > a->size - offset) return NULL;
+    return a->base + offset;
+}
+
+/*
+ * Functionality: Maps the archive at path read-only and checks its header. Returns false if
+ * it cannot be mapped, is not an archive, or was written by a build with another RNG.
+ */
+bool archive_open(Archive *a, const char *path) {
+    memset(a, 0, sizeof(*a));
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < ARCHIVE_HEADER_SIZE) {
+        close(fd);
+        return false;
+    }
+    void *p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // The mapping keeps the file open
+    if (p == MAP_FAILED) return false;
+    a->base = (const uint8_t *)p;
+    a->size = (size_t)st.st_size;
+
+    const uint8_t *h = a->base;
+    a->game_count = (int)get_le(h + 8, 4);
+    a->snapshot_interval = (int)get_le(h + 12, 4);
+    a->index = archive_span(a, get_le(h + 24, 8), (uint64_t)a->game_count * ARCHIVE_INDEX_ENTRY_SIZE);
+    if (memcmp(h, ARCHIVE_MAGIC, 4) != 0 || get_le(h + 4, 4) != ARCHIVE_VERSION ||
+        get_le(h + 16, 4) != sizeof(Rng) || a->snapshot_interval < 1 || !a->index) {
+        archive_close(a);
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Functionality: Unmaps the archive.
+ */
+void archive_close(Archive *a) {
+    if (a->base) munmap((void *)a->base, a->size);
+    memset(a, 0, sizeof(*a));
+}
+
+/*
+ * Functionality: Looks up game i, filling in its replay header and pointing *entries at
+ * its encoded entries inside the mapping. Returns false if i or the entry is invalid.
+ */
+bool archive_game(const Archive *a, int i, ReplayHeader *h, const uint8_t **entries, size_t *size) {
+    if (i < 0 || i >= a->game_count) return false;
+    const uint8_t *entry = a->index + (size_t)i * ARCHIVE_INDEX_ENTRY_SIZE;
+    uint64_t replay_size = get_le(entry + 8, 8);
+    const uint8_t *replay = archive_span(a, get_le(entry, 8), replay_size);
+    if (!replay || !replay_decode_header(replay, replay_size, h)) return false;
+    *entries = replay + REPLAY_HEADER_SIZE;
+    *size = replay_size - REPLAY_HEADER_SIZE;
+    return true;
+}
+
+/*
+ * Functionality: Restores the size bytes of snapshot data into g, a game freshly started from
+ * the same replay header, and positions r in the log to match. Returns false if the
+ * snapshot is corrupt.
+ */
+static bool restore_snapshot(GameState *g, ReplayReader *r, const uint8_t *data, size_t size) {
+    if (size < SNAPSHOT_FIXED_SIZE + sizeof(Rng)) return false;
+    int length = (int)get_le(data + 44, 4);
+    int free_count = (int)get_le(data + 48, 4);
+    uint8_t flags = data[35];
+    size_t need = SNAPSHOT_FIXED_SIZE + sizeof(Rng) + 8 + packed_size(length);
+    if (flags & SNAP_FREE_SET) need += (size_t)free_count * 4;
+    if (length < 1 || need > size || data[33] > RIGHT || data[34] > RIGHT) return false;
+
+    const uint8_t *p = data + SNAPSHOT_FIXED_SIZE;
+    memcpy(&g->rng, p, sizeof(Rng));
+    p += sizeof(Rng);
+
+    Point *segments = (Point *)malloc((size_t)length * sizeof(Point));
+    if (!segments) return false;
+    Point head = { (int)get_le(p, 2), (int)get_le(p + 2, 2) };
+    Point tail = { (int)get_le(p + 4, 2), (int)get_le(p + 6, 2) };
+    packed_unpack(head, length, p + 8, segments);
+    p += 8 + packed_size(length);
+
+    // Decoding must land on the stored tail without leaving the grid
+    bool ok = segments[length - 1].x == tail.x && segments[length - 1].y == tail.y;
+    for (int i = 0; ok && i < length; i++) {
+        ok = segments[i].x >= 0 && segments[i].x <= g->pit_width + 1 &&
+             segments[i].y >= 0 && segments[i].y <= g->pit_height + 1;
+    }
+    ok = ok && game_load_snake(g, segments, length, (Direction)data[34]);
+    free(segments);
+    if (!ok || g->free_count != free_count) return false;
+
+    if (flags & SNAP_FREE_SET) {
+        int *cells = (int *)malloc((size_t)(free_count ? free_count : 1) * sizeof(int));
+        if (!cells) return false;
+        for (int i = 0; i < free_count; i++, p += 4) {
+            cells[i] = (int)get_le(p, 4);
+        }
+        ok = game_load_free_set(g, cells, free_count);
+        free(cells);
+        if (!ok) return false;
+    }
+
+    g->ticks = (long)get_le(data, 8);
+    g->food.x = (int32_t)get_le(data + 36, 4);
+    g->food.y = (int32_t)get_le(data + 40, 4);
+    g->game_over = flags & SNAP_GAME_OVER;
+    g->victory = flags & SNAP_VICTORY;
+
+    r->pos = get_le(data + 8, 8);
+    r->tick = (long)get_le(data + 16, 8);
+    r->pending_tick = (long)get_le(data + 24, 8);
+    r->pending = data[32];
+    r->pending_dir = (Direction)data[33];
+    return r->pos <= r->size;
+}
+
+/*
+ * Functionality: Initializes g as game i at tick `tick` (capped at the game's end): restores
+ * the nearest snapshot at or before it, then simulates forward from there. h receives the
+ * game's replay header. The caller frees g with game_free(). Returns false on a bad index
+ * or a corrupt archive.
+ */
+bool archive_seek(const Archive *a, int i, long tick, GameState *g, ReplayHeader *h) {
+    const uint8_t *entries;
+    size_t size;
+    if (!archive_game(a, i, h, &entries, &size) || !replay_start(g, h)) return false;
+
+    ReplayReader reader;
+    replay_reader_init(&reader, entries, size);
+
+    const uint8_t *entry = a->index + (size_t)i * ARCHIVE_INDEX_ENTRY_SIZE;
+    uint64_t table_offset = get_le(entry + 16, 8);
+    uint64_t count = get_le(entry + 24, 8);
+    uint64_t k = tick < a->snapshot_interval ? 0 : (uint64_t)(tick / a->snapshot_interval);
+    if (k > count) k = count;
+
+    bool ok = true;
+    if (k > 0) {
+        const uint8_t *table = archive_span(a, table_offset, count * 8);
+        const uint8_t *snap = NULL;
+        uint64_t snap_offset = 0, snap_end = table_offset;
+        if (table) {
+            snap_offset = get_le(table + (k - 1) * 8, 8);
+            if (k < count) snap_end = get_le(table + k * 8, 8);
+            if (snap_end >= snap_offset) snap = archive_span(a, snap_offset, snap_end - snap_offset);
+        }
+        ok = snap && restore_snapshot(g, &reader, snap, (size_t)(snap_end - snap_offset));
+    }
+    ok = ok && replay_play(g, &reader, h, tick);
+    if (!ok) game_free(g);
+    return ok;
+}
@@ -0,0 +1,72 @@
+#ifndef ARCHIVE_H
+#define ARCHIVE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "game.h"
+#include "replay.h"
+#include "packed.h"
+
+/*
+ * Replay archives: many replay logs in one file, read through mmap. Besides
+ * each game's log the archive stores a full state snapshot every
+ * snapshot_interval ticks, so seeking to tick T restores the snapshot at or
+ * before T and simulates at most snapshot_interval - 1 ticks forward instead
+ * of replaying from tick 0.
+ *
+ * Layout (all integers little-endian, offsets from the start of the file):
+ *   header:   magic "SNKA", version u32, game_count u32, snapshot_interval u32,
+ *             rng_size u32, reserved u32, index_offset u64
+ *   per game: the replay log exactly as on disk, then its snapshots, then a
+ *             table of snapshot offsets (u64 each; snapshot k is at tick
+ *             (k + 1) * snapshot_interval)
+ *   index:    per game replay_offset u64, replay_size u64, snapshots_offset u64,
+ *             snapshot_count u64
+ *
+ * A snapshot is ticks u64, the replay reader's pos/tick/pending_tick u64,
+ * pending/pending_dir/dir/flags u8, food x/y i32, length u32, free_count u32,
+ * the raw RNG state, head and tail as u16 x/y pairs, the body's moves packed
+ * 2 bits per segment (see packed.h, packed_size(length) bytes) and, once
+ * the game has built its free-cell set, that set's cells as u32 in order, so
+ * food placement after a restore matches the original game exactly.
+ */
+
+#define ARCHIVE_MAGIC "SNKA"
+#define ARCHIVE_VERSION 2
+#define ARCHIVE_HEADER_SIZE 32
+#define ARCHIVE_INDEX_ENTRY_SIZE 32
+#define DEFAULT_SNAPSHOT_INTERVAL 1024
+
+// Read side: a mapped archive
+typedef struct {
+    const uint8_t *base;
+    size_t size;
+    int game_count;
+    int snapshot_interval;
+    const uint8_t *index;
+} Archive;
+
+// Write side: appends games to a new archive file
+typedef struct {
+    FILE *file;
+    int snapshot_interval;
+    int game_count;
+    uint8_t *index;         // ARCHIVE_INDEX_ENTRY_SIZE bytes per game added so far
+    int index_capacity;
+    uint8_t *snapshot;      // Scratch buffer for encoding one snapshot
+    size_t snapshot_capacity;
+    PackedBody body;        // Scratch packed body for the snapshot being encoded
+} ArchiveWriter;
+
+bool archive_create(ArchiveWriter *w, const char *path, int snapshot_interval);
+bool archive_add(ArchiveWriter *w, const ReplayHeader *h, const uint8_t *entries, size_t size);
+bool archive_finish(ArchiveWriter *w);
+
+bool archive_open(Archive *a, const char *path);
+void archive_close(Archive *a);
+bool archive_game(const Archive *a, int i, ReplayHeader *h, const uint8_t **entries, size_t *size);
+bool archive_seek(const Archive *a, int i, long tick, GameState *g, ReplayHeader *h);
+
+#endif
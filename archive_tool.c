@@ -0,0 +1,159 @@
+#define _POSIX_C_SOURCE 200809L // clock_gettime, getopt
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "game.h"
+#include "replay.h"
+#include "archive.h"
+
+/*
+ * Replay archive tool: packs replay logs into one archive with periodic
+ * snapshots, lists its games, and seeks straight to any tick of any game.
+ *
+ * Usage: snake_archive build [-k interval] archive replay...
+ *        snake_archive list archive
+ *        snake_archive seek archive game tick
+ */
+
+/*
+ * Functionality: Returns the monotonic clock in seconds.
+ */
+static double now_sec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+ * Functionality: Prints usage to stderr.
+ */
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s build [-k interval] archive replay...\n", prog);
+    fprintf(stderr, "       %s list archive\n", prog);
+    fprintf(stderr, "       %s seek archive game tick\n", prog);
+}
+
+/*
+ * Functionality: Builds an archive from replay files. Returns the exit status.
+ */
+static int cmd_build(int argc, char **argv) {
+    int interval = DEFAULT_SNAPSHOT_INTERVAL;
+    int opt;
+    while ((opt = getopt(argc, argv, "k:")) != -1) {
+        switch (opt) {
+            case 'k':
+                interval = atoi(optarg);
+                break;
+            default:
+                return 2;
+        }
+    }
+    if (optind >= argc) return 2;
+
+    const char *path = argv[optind];
+    ArchiveWriter writer;
+    if (!archive_create(&writer, path, interval)) {
+        perror(path);
+        return 1;
+    }
+
+    int status = 0;
+    for (int i = optind + 1; i < argc; i++) {
+        ReplayHeader header;
+        size_t size;
+        uint8_t *entries = replay_load(argv[i], &header, &size);
+        if (!entries) {
+            fprintf(stderr, "%s: not a readable replay, skipped\n", argv[i]);
+            status = 1;
+            continue;
+        }
+        if (!archive_add(&writer, &header, entries, size)) {
+            fprintf(stderr, "%s: cannot archive (write error or log does not replay)\n", argv[i]);
+            free(entries);
+            archive_finish(&writer);
+            return 1;
+        }
+        free(entries);
+    }
+
+    int games = writer.game_count;
+    if (!archive_finish(&writer)) {
+        fprintf(stderr, "%s: write failed\n", path);
+        return 1;
+    }
+    printf("%s: %d games, snapshot every %d ticks\n", path, games, interval);
+    return status;
+}
+
+/*
+ * Functionality: Lists the games in an archive. Returns the exit status.
+ */
+static int cmd_list(const char *path) {
+    Archive archive;
+    if (!archive_open(&archive, path)) {
+        fprintf(stderr, "%s: not a readable archive\n", path);
+        return 1;
+    }
+
+    printf("games=%d snapshot_interval=%d bytes=%zu\n", archive.game_count, archive.snapshot_interval,
+           archive.size);
+    for (int i = 0; i < archive.game_count; i++) {
+        ReplayHeader h;
+        const uint8_t *entries;
+        size_t size;
+        if (!archive_game(&archive, i, &h, &entries, &size)) {
+            fprintf(stderr, "%s: game %d is corrupt\n", path, i);
+            archive_close(&archive);
+            return 1;
+        }
+        printf("%d pit=%dx%d seed=%llu ticks=%ld length=%d log_bytes=%zu\n", i, h.pit_height,
+               h.pit_width, (unsigned long long)h.seed, h.ticks, h.final_length, size);
+    }
+    archive_close(&archive);
+    return 0;
+}
+
+/*
+ * Functionality: Seeks one game to a tick and prints its state there. Returns the exit status.
+ */
+static int cmd_seek(const char *path, int game_index, long tick) {
+    Archive archive;
+    if (!archive_open(&archive, path)) {
+        fprintf(stderr, "%s: not a readable archive\n", path);
+        return 1;
+    }
+
+    GameState game;
+    ReplayHeader h;
+    double start = now_sec();
+    if (!archive_seek(&archive, game_index, tick, &game, &h)) {
+        fprintf(stderr, "%s: cannot seek game %d\n", path, game_index);
+        archive_close(&archive);
+        return 1;
+    }
+    double elapsed = now_sec() - start;
+
+    Point head = *snake_segment(&game, 0);
+    printf("game=%d tick=%ld length=%d head=%d,%d food=%d,%d state=%s seek_us=%.1f\n", game_index,
+           game.ticks, game.snake.length, head.x, head.y, game.food.x, game.food.y,
+           game.victory ? "won" : game.game_over ? "lost" : "running", elapsed * 1e6);
+    game_free(&game);
+    archive_close(&archive);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    int status = 2;
+    if (argc >= 2 && strcmp(argv[1], "build") == 0) {
+        status = cmd_build(argc - 1, argv + 1);
+    } else if (argc == 3 && strcmp(argv[1], "list") == 0) {
+        status = cmd_list(argv[2]);
+    } else if (argc == 5 && strcmp(argv[1], "seek") == 0) {
+        status = cmd_seek(argv[2], atoi(argv[3]), atol(argv[4]));
+    }
+    if (status == 2) usage(argv[0]);
+    return status;
+}
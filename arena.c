@@ -0,0 +1,48 @@
+#define _DEFAULT_SOURCE // MAP_ANONYMOUS, MAP_NORESERVE
+#include <string.h>
+#include <sys/mman.h>
+
+#include "arena.h"
+#include "alloc.h"
+
+/*
+ * Functionality: Reserves size bytes of zero-filled address space. Returns false if the
+ * reservation could not be made.
+ */
+bool arena_init(Arena *a, size_t size) {
+    a->base = NULL;
+    a->size = 0;
+    a->used = 0;
+    if (size == 0) return true;
+
+    // NORESERVE: nothing is committed until it is touched
+    void *p = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (p == MAP_FAILED) return false;
+    alloc_note();
+    a->base = (unsigned char *)p;
+    a->size = size;
+    return true;
+}
+
+/*
+ * Functionality: Hands out the next size bytes (zeroed on first use, aligned to
+ * ARENA_ALIGN). Returns NULL when the reservation is exhausted.
+ */
+void *arena_alloc(Arena *a, size_t size) {
+    size = arena_round(size);
+    if (size > a->size - a->used) return NULL;
+    void *p = a->base + a->used;
+    a->used += size;
+    return p;
+}
+
+/*
+ * Functionality: Returns the reservation to the system.
+ */
+void arena_free(Arena *a) {
+    if (a->base) munmap(a->base, a->size);
+    a->base = NULL;
+    a->size = 0;
+    a->used = 0;
+}
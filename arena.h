@@ -0,0 +1,32 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Bump allocator over one up-front reservation. The reservation is mapped
+ * without committing memory, so pages only become resident once something is
+ * written to them: a game can reserve room for its worst case (a snake filling
+ * a 4096x4096 pit) while only paying for what it actually uses.
+ */
+typedef struct {
+    unsigned char *base;
+    size_t size;   // Bytes reserved
+    size_t used;   // Bytes handed out so far
+} Arena;
+
+#define ARENA_ALIGN 64 // Every block starts on its own cache line
+
+bool arena_init(Arena *a, size_t size);
+void *arena_alloc(Arena *a, size_t size);
+void arena_free(Arena *a);
+
+/*
+ * Functionality: Rounds a block size up to the arena alignment.
+ */
+static inline size_t arena_round(size_t size) {
+    return (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+}
+
+#endif
@@ -0,0 +1,224 @@
+#define _POSIX_C_SOURCE 200809L // posix_memalign
+#include <stdlib.h>
+#include <string.h>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "batch.h"
+
+// Lanes processed per SIMD iteration; arrays are padded to a multiple of this
+#if defined(__AVX2__)
+#define BATCH_LANES 8
+#elif defined(__SSE2__)
+#define BATCH_LANES 4
+#else
+#define BATCH_LANES 1
+#endif
+#define BATCH_ALIGN 32
+
+/*
+ * Functionality: Allocates one zeroed, SIMD-aligned int32 array of n entries.
+ */
+static int32_t *alloc_lanes(int n) {
+    void *p = NULL;
+    if (posix_memalign(&p, BATCH_ALIGN, (size_t)n * sizeof(int32_t)) != 0) return NULL;
+    memset(p, 0, (size_t)n * sizeof(int32_t));
+    return (int32_t *)p;
+}
+
+/*
+ * Functionality: Copies the hot fields of game i from its GameState into the arrays.
+ */
+static void load_lane(GameBatch *b, int i) {
+    const GameState *g = &b->games[i];
+    Point head = *snake_segment(g, 0);
+    b->head_x[i] = head.x;
+    b->head_y[i] = head.y;
+    b->dir[i] = g->snake.dir;
+    b->food_x[i] = g->food.x;
+    b->food_y[i] = g->food.y;
+    b->alive[i] = (g->game_over || g->victory) ? 0 : -1;
+}
+
+/*
+ * Functionality: Allocates a batch of count games on a pit_height x pit_width pit. Every
+ * lane starts as a finished game; call batch_reset_game() to start each one.
+ */
+bool batch_init(GameBatch *b, int count, int pit_height, int pit_width) {
+    memset(b, 0, sizeof(*b));
+    b->count = count;
+    b->padded = (count + BATCH_LANES - 1) / BATCH_LANES * BATCH_LANES;
+    b->pit_height = pit_height;
+    b->pit_width = pit_width;
+
+    int32_t **arrays[] = { &b->head_x, &b->head_y, &b->dir, &b->food_x, &b->food_y,
+                           &b->alive, &b->next_x, &b->next_y, &b->hit_wall, &b->ate };
+    for (size_t k = 0; k < sizeof(arrays) / sizeof(arrays[0]); k++) {
+        *arrays[k] = alloc_lanes(b->padded);
+        if (!*arrays[k]) {
+            batch_free(b);
+            return false;
+        }
+    }
+    b->games = (GameState *)calloc(count, sizeof(GameState));
+    if (!b->games) {
+        batch_free(b);
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Functionality: Releases every game and array owned by the batch.
+ */
+void batch_free(GameBatch *b) {
+    if (b->games) {
+        for (int i = 0; i < b->count; i++) {
+            game_free(&b->games[i]);
+        }
+    }
+    free(b->games);
+    free(b->head_x);
+    free(b->head_y);
+    free(b->dir);
+    free(b->food_x);
+    free(b->food_y);
+    free(b->alive);
+    free(b->next_x);
+    free(b->next_y);
+    free(b->hit_wall);
+    free(b->ate);
+    memset(b, 0, sizeof(*b));
+}
+
+/*
+ * Functionality: Starts a fresh game in lane i with the given seed. Returns false if
+ * memory could not be allocated.
+ */
+bool batch_reset_game(GameBatch *b, int i, uint64_t seed) {
+    if (b->games[i].snake.body) {
+        game_reset(&b->games[i], seed); // Reuse the lane's memory from its last game
+    } else if (!game_init(&b->games[i], b->pit_height, b->pit_width, seed)) {
+        return false;
+    }
+    load_lane(b, i);
+    return true;
+}
+
+/*
+ * Functionality: Turns the snake in lane i, with the same no-reversal rule as game_turn().
+ */
+void batch_turn(GameBatch *b, int i, Direction dir) {
+    game_turn(&b->games[i], dir);
+    b->dir[i] = b->games[i].snake.dir;
+}
+
+/*
+ * Functionality: Computes the advanced head, wall hit and food hit for every lane. The
+ * direction is turned into a step with compares (dx = [RIGHT] - [LEFT], dy = [DOWN] - [UP])
+ * so the whole pass is branch-free.
+ */
+static void advance_heads(GameBatch *b) {
+    int i = 0;
+#if defined(__AVX2__)
+    const __m256i up = _mm256_set1_epi32(UP), down = _mm256_set1_epi32(DOWN);
+    const __m256i left = _mm256_set1_epi32(LEFT), right = _mm256_set1_epi32(RIGHT);
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i width = _mm256_set1_epi32(b->pit_width);
+    const __m256i height = _mm256_set1_epi32(b->pit_height);
+    for (; i < b->padded; i += 8) {
+        __m256i d = _mm256_load_si256((const __m256i *)&b->dir[i]);
+        // Compare masks are -1 when true, so dx/dy hold the negated step and "head - d" advances
+        __m256i dx = _mm256_sub_epi32(_mm256_cmpeq_epi32(d, right), _mm256_cmpeq_epi32(d, left));
+        __m256i dy = _mm256_sub_epi32(_mm256_cmpeq_epi32(d, down), _mm256_cmpeq_epi32(d, up));
+        __m256i nx = _mm256_sub_epi32(_mm256_load_si256((const __m256i *)&b->head_x[i]), dx);
+        __m256i ny = _mm256_sub_epi32(_mm256_load_si256((const __m256i *)&b->head_y[i]), dy);
+        __m256i wall = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpgt_epi32(one, nx), _mm256_cmpgt_epi32(nx, width)),
+            _mm256_or_si256(_mm256_cmpgt_epi32(one, ny), _mm256_cmpgt_epi32(ny, height)));
+        __m256i ate = _mm256_and_si256(
+            _mm256_cmpeq_epi32(nx, _mm256_load_si256((const __m256i *)&b->food_x[i])),
+            _mm256_cmpeq_epi32(ny, _mm256_load_si256((const __m256i *)&b->food_y[i])));
+        _mm256_store_si256((__m256i *)&b->next_x[i], nx);
+        _mm256_store_si256((__m256i *)&b->next_y[i], ny);
+        _mm256_store_si256((__m256i *)&b->hit_wall[i], wall);
+        _mm256_store_si256((__m256i *)&b->ate[i], ate);
+    }
+#elif defined(__SSE2__)
+    const __m128i up = _mm_set1_epi32(UP), down = _mm_set1_epi32(DOWN);
+    const __m128i left = _mm_set1_epi32(LEFT), right = _mm_set1_epi32(RIGHT);
+    const __m128i one = _mm_set1_epi32(1);
+    const __m128i width = _mm_set1_epi32(b->pit_width);
+    const __m128i height = _mm_set1_epi32(b->pit_height);
+    for (; i < b->padded; i += 4) {
+        __m128i d = _mm_load_si128((const __m128i *)&b->dir[i]);
+        // Compare masks are -1 when true, so dx/dy hold the negated step and "head - d" advances
+        __m128i dx = _mm_sub_epi32(_mm_cmpeq_epi32(d, right), _mm_cmpeq_epi32(d, left));
+        __m128i dy = _mm_sub_epi32(_mm_cmpeq_epi32(d, down), _mm_cmpeq_epi32(d, up));
+        __m128i nx = _mm_sub_epi32(_mm_load_si128((const __m128i *)&b->head_x[i]), dx);
+        __m128i ny = _mm_sub_epi32(_mm_load_si128((const __m128i *)&b->head_y[i]), dy);
+        __m128i wall = _mm_or_si128(
+            _mm_or_si128(_mm_cmplt_epi32(nx, one), _mm_cmpgt_epi32(nx, width)),
+            _mm_or_si128(_mm_cmplt_epi32(ny, one), _mm_cmpgt_epi32(ny, height)));
+        __m128i ate = _mm_and_si128(
+            _mm_cmpeq_epi32(nx, _mm_load_si128((const __m128i *)&b->food_x[i])),
+            _mm_cmpeq_epi32(ny, _mm_load_si128((const __m128i *)&b->food_y[i])));
+        _mm_store_si128((__m128i *)&b->next_x[i], nx);
+        _mm_store_si128((__m128i *)&b->next_y[i], ny);
+        _mm_store_si128((__m128i *)&b->hit_wall[i], wall);
+        _mm_store_si128((__m128i *)&b->ate[i], ate);
+    }
+#endif
+    // Scalar path (and tail when no SIMD is available)
+    for (; i < b->padded; i++) {
+        int32_t d = b->dir[i];
+        int32_t nx = b->head_x[i] + (d == RIGHT) - (d == LEFT);
+        int32_t ny = b->head_y[i] + (d == DOWN) - (d == UP);
+        b->next_x[i] = nx;
+        b->next_y[i] = ny;
+        b->hit_wall[i] = -(nx < 1 || nx > b->pit_width || ny < 1 || ny > b->pit_height);
+        b->ate[i] = -(nx == b->food_x[i] && ny == b->food_y[i]);
+    }
+}
+
+/*
+ * Functionality: Advances every running game in the batch by one tick. The head, wall and
+ * food tests run vectorized across lanes; the body/grid update is then applied per game.
+ * Returns the number of games still running.
+ */
+int batch_step(GameBatch *b) {
+    advance_heads(b);
+
+    int running = 0;
+    for (int i = 0; i < b->count; i++) {
+        if (!b->alive[i]) continue;
+        GameState *g = &b->games[i];
+        Point new_head = { b->next_x[i], b->next_y[i] };
+
+        g->ticks++;
+        if (b->hit_wall[i]) {
+            // Same outcome as update_snake() + check_collision() on a wall hit
+            game_advance(g, new_head, false);
+            g->game_over = true;
+        } else {
+            game_advance(g, new_head, b->ate[i] != 0);
+            if (g->occupancy[grid_cell(g, new_head.x, new_head.y)] > 1) {
+                g->game_over = true;
+            } else if (check_win(g)) {
+                g->victory = true;
+            }
+        }
+
+        b->head_x[i] = new_head.x;
+        b->head_y[i] = new_head.y;
+        b->food_x[i] = g->food.x;
+        b->food_y[i] = g->food.y;
+        if (g->game_over || g->victory) {
+            b->alive[i] = 0;
+        } else {
+            running++;
+        }
+    }
+    return running;
+}
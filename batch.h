@@ -0,0 +1,38 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stdint.h>
+
+#include "game.h"
+
+/*
+ * Structure-of-arrays batch of games sharing one pit size. The per-tick hot
+ * fields (head, direction, food) live in parallel int32 arrays so the head
+ * advance, wall test and food test run as SIMD over many games at once; the
+ * cold per-game data (body ring, grid, RNG) stays in each lane's GameState.
+ */
+typedef struct {
+    int count;         // Games in the batch
+    int padded;        // count rounded up to the SIMD width
+    int pit_height;
+    int pit_width;
+    int32_t *head_x;   // Hot state, one entry per game
+    int32_t *head_y;
+    int32_t *dir;
+    int32_t *food_x;
+    int32_t *food_y;
+    int32_t *alive;    // -1 while running, 0 once over (SIMD mask form)
+    int32_t *next_x;   // Scratch: advanced heads
+    int32_t *next_y;
+    int32_t *hit_wall; // Scratch: -1 where the advanced head left the pit
+    int32_t *ate;      // Scratch: -1 where the advanced head is on the food
+    GameState *games;  // Cold per-game state
+} GameBatch;
+
+bool batch_init(GameBatch *b, int count, int pit_height, int pit_width);
+void batch_free(GameBatch *b);
+bool batch_reset_game(GameBatch *b, int i, uint64_t seed);
+void batch_turn(GameBatch *b, int i, Direction dir);
+int batch_step(GameBatch *b);
+
+#endif
@@ -0,0 +1,296 @@
+#define _POSIX_C_SOURCE 200809L // clock_gettime, setenv, getopt
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "game.h"
+#include "ai.h"
+#include "render.h"
+
+/*
+ * Micro-benchmarks for the hot game functions across a sweep of pit sizes and
+ * fill levels. Each case lays a snake of the requested length along a
+ * Hamiltonian cycle of the pit and steers it around that cycle, so it can
+ * move forever without dying or eating and the fill stays constant.
+ *
+ * Output is CSV on stdout: bench,pit,fill,length,iterations,ns_per_op,ops_per_sec
+ *
+ * Usage: snake_bench [-s HxW] [-f fill] [-t seconds]
+ */
+
+#define QUERY_POINTS 4096 // Random coordinates cycled through by is_snake_position
+
+typedef struct {
+    GameState game;
+    Direction *cycle_dir;       // Next direction along the cycle, per grid cell
+    Point queries[QUERY_POINTS];
+    long sink;                  // Keeps results observable so calls are not elided
+} BenchCase;
+
+typedef void (*BenchFn)(BenchCase *c, long iterations);
+
+/*
+ * Functionality: Returns the monotonic clock in nanoseconds.
+ */
+static long long now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/*
+ * Functionality: Returns the direction of the step from a to the adjacent cell b.
+ */
+static Direction step_direction(Point a, Point b) {
+    if (b.x > a.x) return RIGHT;
+    if (b.x < a.x) return LEFT;
+    if (b.y > a.y) return DOWN;
+    return UP;
+}
+
+/*
+ * Functionality: Builds a case: a snake of `length` segments laid along the pit's cycle,
+ * food parked off the board, and a table of random query points.
+ */
+static bool setup_case(BenchCase *c, int h, int w, int length) {
+    int cells = h * w;
+    Point *order = (Point *)malloc(cells * sizeof(Point));
+    Point *segments = (Point *)malloc(length * sizeof(Point));
+    if (!order || !segments || !hamiltonian_cycle(h, w, order) || !game_init(&c->game, h, w, 1)) {
+        free(order);
+        free(segments);
+        return false;
+    }
+
+    GameState *g = &c->game;
+    c->cycle_dir = (Direction *)malloc((size_t)(h + 2) * g->grid_stride * sizeof(Direction));
+    for (int k = 0; k < cells; k++) {
+        c->cycle_dir[grid_cell(g, order[k].x, order[k].y)] =
+            step_direction(order[k], order[(k + 1) % cells]);
+    }
+
+    // Head at cycle position length - 1, tail at position 0
+    for (int i = 0; i < length; i++) {
+        segments[i] = order[length - 1 - i];
+    }
+    Direction dir = step_direction(order[length - 1], order[length % cells]);
+    bool ok = game_load_snake(g, segments, length, dir);
+    g->food.x = -1;
+    g->food.y = -1;
+
+    for (int i = 0; i < QUERY_POINTS; i++) {
+        c->queries[i].x = (int)rng_below(&g->rng, w) + 1;
+        c->queries[i].y = (int)rng_below(&g->rng, h) + 1;
+    }
+    c->sink = 0;
+
+    free(order);
+    free(segments);
+    return ok;
+}
+
+/*
+ * Functionality: Releases a case.
+ */
+static void teardown_case(BenchCase *c) {
+    game_free(&c->game);
+    free(c->cycle_dir);
+}
+
+/*
+ * Functionality: Steers the snake one step along the cycle.
+ */
+static inline void follow_cycle(BenchCase *c) {
+    GameState *g = &c->game;
+    Point head = *snake_segment(g, 0);
+    g->snake.dir = c->cycle_dir[grid_cell(g, head.x, head.y)];
+}
+
+static void bench_update_snake(BenchCase *c, long iterations) {
+    for (long i = 0; i < iterations; i++) {
+        follow_cycle(c);
+        update_snake(&c->game);
+    }
+}
+
+static void bench_step_kernel(BenchCase *c, long iterations) {
+    for (long i = 0; i < iterations; i++) {
+        follow_cycle(c);
+        c->sink += c->game.step(&c->game);
+    }
+}
+
+static void bench_check_collision(BenchCase *c, long iterations) {
+    for (long i = 0; i < iterations; i++) {
+        c->sink += check_collision(&c->game);
+    }
+}
+
+static void bench_is_snake_position(BenchCase *c, long iterations) {
+    for (long i = 0; i < iterations; i++) {
+        Point p = c->queries[i & (QUERY_POINTS - 1)];
+        c->sink += is_snake_position(&c->game, p.x, p.y);
+    }
+}
+
+static void bench_place_food(BenchCase *c, long iterations) {
+    for (long i = 0; i < iterations; i++) {
+        place_food(&c->game);
+        c->sink += c->game.food.x;
+    }
+    // Park the food again so later moves never eat
+    c->game.food.x = -1;
+    c->game.food.y = -1;
+}
+
+static void bench_render_full(BenchCase *c, long iterations) {
+    for (long i = 0; i < iterations; i++) {
+        draw_full_frame(&c->game);
+    }
+}
+
+static void bench_render_move(BenchCase *c, long iterations) {
+    GameState *g = &c->game;
+    for (long i = 0; i < iterations; i++) {
+        Point old_head = *snake_segment(g, 0);
+        Point old_tail = *snake_segment(g, g->snake.length - 1);
+        follow_cycle(c);
+        update_snake(g);
+        draw_changes(g, old_head, old_tail, g->snake.length, g->food);
+        doupdate();
+    }
+}
+
+/*
+ * Functionality: Times fn, growing the iteration count until one run lasts at least
+ * min_ns, and prints one CSV row.
+ */
+static void run_bench(const char *name, BenchFn fn, BenchCase *c, double fill, long long min_ns) {
+    long iterations = 1;
+    long long elapsed;
+    for (;;) {
+        long long start = now_ns();
+        fn(c, iterations);
+        elapsed = now_ns() - start;
+        if (elapsed >= min_ns) break;
+        // Aim a little past the target so the next run usually suffices
+        long long scale = elapsed > 0 ? (min_ns * 12 / 10) / elapsed + 1 : 100;
+        if (scale > 100) scale = 100;
+        iterations *= scale;
+    }
+
+    double ns_per_op = (double)elapsed / iterations;
+    printf("%s,%dx%d,%.2f,%d,%ld,%.2f,%.0f\n", name, c->game.pit_height, c->game.pit_width,
+           fill, c->game.snake.length, iterations, ns_per_op, 1e9 / ns_per_op);
+    fflush(stdout);
+}
+
+/*
+ * Functionality: Starts ncurses on /dev/null with a max_h x max_w pit's screen, so render
+ * benchmarks measure ncurses work without a real terminal.
+ */
+static bool start_render_screen(int max_h, int max_w) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%d", max_h + 4);
+    setenv("LINES", buf, 1);
+    snprintf(buf, sizeof(buf), "%d", max_w + 4);
+    setenv("COLUMNS", buf, 1);
+
+    FILE *out = fopen("/dev/null", "w");
+    const char *term = getenv("TERM");
+    if (!out || !newterm(term && *term ? term : "xterm", out, stdin)) {
+        fprintf(stderr, "snake_bench: no terminal for render benchmarks, skipping them\n");
+        return false;
+    }
+    init_colors();
+    return true;
+}
+
+/*
+ * Functionality: Runs every benchmark for one pit size and fill level.
+ */
+static void bench_case(int h, int w, double fill, long long min_ns, bool render) {
+    int length = (int)(fill * h * w);
+    if (length < 3) length = 3;
+
+    BenchCase *c = (BenchCase *)calloc(1, sizeof(BenchCase));
+    if (!c || !setup_case(c, h, w, length)) {
+        fprintf(stderr, "snake_bench: cannot set up %dx%d (need an even side, enough memory)\n", h, w);
+        free(c);
+        return;
+    }
+
+    run_bench("update_snake", bench_update_snake, c, fill, min_ns);
+    run_bench("check_collision", bench_check_collision, c, fill, min_ns);
+    // update_snake plus check_collision through the kernel game_init() picked
+    run_bench(strcmp(game_kernel_name(&c->game), "generic") ? "step_specialized" : "step_generic",
+              bench_step_kernel, c, fill, min_ns);
+    run_bench("is_snake_position", bench_is_snake_position, c, fill, min_ns);
+    run_bench("place_food", bench_place_food, c, fill, min_ns);
+
+    if (render) {
+        // Size the virtual screen to this pit so doupdate() cost matches a real terminal
+        resizeterm(h + 4, w + 4);
+        if (render_open(&c->game, 1, 1, h + 2, w + 2)) {
+            run_bench("render_full", bench_render_full, c, fill, min_ns);
+            run_bench("render_move", bench_render_move, c, fill, min_ns);
+        }
+        render_close();
+    }
+
+    teardown_case(c);
+    free(c);
+}
+
+int main(int argc, char **argv) {
+    // Default sweep, replaced by a single case with -s / -f
+    int sizes[][2] = { { 20, 40 }, { 100, 100 }, { 250, 250 }, { 1000, 1000 } };
+    double fills[] = { 0.10, 0.50, 0.90 };
+    int n_sizes = sizeof(sizes) / sizeof(sizes[0]);
+    int n_fills = sizeof(fills) / sizeof(fills[0]);
+    double seconds = 0.1;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "s:f:t:")) != -1) {
+        switch (opt) {
+            case 's':
+                if (sscanf(optarg, "%dx%d", &sizes[0][0], &sizes[0][1]) != 2 ||
+                    sizes[0][0] < 2 || sizes[0][1] < 2) {
+                    fprintf(stderr, "snake_bench: bad size '%s'\n", optarg);
+                    return 1;
+                }
+                n_sizes = 1;
+                break;
+            case 'f':
+                fills[0] = atof(optarg);
+                n_fills = 1;
+                break;
+            case 't':
+                seconds = atof(optarg);
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-s HxW] [-f fill] [-t seconds]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    int max_h = 0, max_w = 0;
+    for (int i = 0; i < n_sizes; i++) {
+        if (sizes[i][0] > max_h) max_h = sizes[i][0];
+        if (sizes[i][1] > max_w) max_w = sizes[i][1];
+    }
+    bool render = start_render_screen(max_h, max_w);
+    long long min_ns = (long long)(seconds * 1e9);
+
+    printf("bench,pit,fill,length,iterations,ns_per_op,ops_per_sec\n");
+    for (int i = 0; i < n_sizes; i++) {
+        for (int j = 0; j < n_fills; j++) {
+            bench_case(sizes[i][0], sizes[i][1], fills[j], min_ns, render);
+        }
+    }
+
+    if (render) endwin();
+    return 0;
+}
@@ -0,0 +1,28 @@
+#ifndef BYTES_H
+#define BYTES_H
+
+#include <stdint.h>
+
+// Little-endian integer helpers shared by the replay, archive and network formats
+
+/*
+ * Functionality: Stores value little-endian in n bytes at out.
+ */
+static inline void put_le(uint8_t *out, uint64_t value, int n) {
+    for (int i = 0; i < n; i++) {
+        out[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+/*
+ * Functionality: Reads an n-byte little-endian value from in.
+ */
+static inline uint64_t get_le(const uint8_t *in, int n) {
+    uint64_t value = 0;
+    for (int i = 0; i < n; i++) {
+        value |= (uint64_t)in[i] << (8 * i);
+    }
+    return value;
+}
+
+#endif
@@ -0,0 +1,543 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "game.h"
+#include "trace.h"
+
+#define FOOD_SAMPLE_TRIES 8 // Random picks before falling back to the free-cell set
+
+static StepKernel pick_step_kernel(int pit_height, int pit_width); // Defined with the kernels
+
+/*
+ * Functionality: Returns true if (x, y) lies inside the pit rather than on the border.
+ */
+static inline bool in_pit(const GameState *g, int x, int y) {
+    return x >= 1 && x <= g->pit_width && y >= 1 && y <= g->pit_height;
+}
+
+/*
+ * Functionality: Adds a snake segment to a grid cell, dropping an inside cell from the free
+ * set when it stops being empty.
+ */
+static void occupy_cell(GameState *g, int cell, bool inside) {
+    if (g->occupancy[cell]++ != 0 || !inside) return;
+    g->free_count--;
+    if (g->free_set_ready) {
+        int pos = g->free_pos[cell] - 1;
+        int last = g->free_cells[g->free_count];
+        g->free_cells[pos] = last;
+        g->free_pos[last] = pos + 1;
+        g->free_pos[cell] = 0;
+    }
+}
+
+/*
+ * Functionality: Removes a snake segment from an inside grid cell, returning the cell to the
+ * free set once it is empty.
+ */
+static void vacate_cell(GameState *g, int cell) {
+    if (--g->occupancy[cell] != 0) return;
+    if (g->free_set_ready) {
+        g->free_cells[g->free_count] = cell;
+        g->free_pos[cell] = g->free_count + 1;
+    }
+    g->free_count++;
+}
+
+/*
+ * Functionality: Builds the free-cell set from the grid in one pass. Happens at most once
+ * per game, when the board has become too crowded for random sampling.
+ */
+static void build_free_set(GameState *g) {
+    int n = 0;
+    for (int y = 1; y <= g->pit_height; y++) {
+        for (int x = 1; x <= g->pit_width; x++) {
+            int cell = grid_cell(g, x, y);
+            if (g->occupancy[cell] == 0) {
+                g->free_cells[n] = cell;
+                g->free_pos[cell] = ++n;
+            }
+        }
+    }
+    g->free_set_ready = true;
+}
+
+/*
+ * Functionality: Moves the body into a ring of new_capacity slots taken from the arena,
+ * laid out head first. Capacities only ever double, so all rings a game allocates add up
+ * to less than twice its final one. Returns false if the arena is exhausted.
+ */
+static bool grow_body(GameState *g, int new_capacity) {
+    Snake *snake = &g->snake;
+    Point *body = (Point *)arena_alloc(&g->arena, (size_t)new_capacity * sizeof(Point));
+    if (!body) return false;
+    for (int i = 0; i < snake->length; i++) {
+        body[i] = *snake_segment(g, i);
+    }
+    snake->body = body; // The old ring stays behind in the arena
+    snake->head = 0;
+    snake->capacity = new_capacity;
+    return true;
+}
+
+/*
+ * Functionality: Initializes the snake with length 3 at the center of the pit.
+ */
+static void init_snake(GameState *g) {
+    Snake *snake = &g->snake;
+
+    // Initialize snake with length 3 at center of the pit
+    snake->head = 0;
+    snake->length = INITIAL_LENGTH;
+    int center_y = g->pit_height / 2 + 1; // local coords (1-based inside border)
+    int center_x = g->pit_width / 2 + 1;
+
+    snake->body[0].y = center_y;
+    snake->body[0].x = center_x;
+    snake->body[1].y = center_y;
+    snake->body[1].x = center_x - 1;
+    snake->body[2].y = center_y;
+    snake->body[2].x = center_x - 2;
+
+    snake->dir = RIGHT; // Initial direction
+
+    // Mark the initial body
+    for (int i = 0; i < snake->length; i++) {
+        occupy_cell(g, grid_cell(g, snake->body[i].x, snake->body[i].y), true);
+    }
+}
+
+/*
+ * Functionality: Allocates and resets a game for a pit_height x pit_width pit, seeding its
+ * private RNG, and places the first food. Everything lives in one arena reserved for the
+ * worst case (a snake filling the pit), but only touched pages are ever committed.
+ * Returns false if the size is out of range or the reservation fails.
+ */
+bool game_init(GameState *g, int pit_height, int pit_width, uint64_t seed) {
+    memset(g, 0, sizeof(*g));
+    if (pit_height < MIN_PIT_SIDE || pit_height > MAX_PIT_SIDE ||
+        pit_width < MIN_PIT_SIDE || pit_width > MAX_PIT_SIDE) {
+        return false;
+    }
+    g->pit_height = pit_height;
+    g->pit_width = pit_width;
+    g->seed = seed;
+    g->step = pick_step_kernel(pit_height, pit_width);
+    rng_seed(&g->rng, seed);
+
+    // Calculate half perimeter for win condition
+    int perimeter = 2 * (pit_height + pit_width);
+    g->snake.max_length = perimeter / 2;
+
+    // Reserve the grid (pit plus border), the free-cell set and every body ring the
+    // snake could ever need: doubling from INITIAL_BODY_CAPACITY up to one slot more
+    // than the pit holds allocates under 4 * (cells + 1) slots in total.
+    g->grid_stride = pit_width + 2;
+    size_t grid_size = (size_t)(pit_height + 2) * g->grid_stride;
+    size_t cells = (size_t)pit_height * pit_width;
+    size_t body_slots = 4 * (cells + 1) + INITIAL_BODY_CAPACITY;
+    size_t reserve = arena_round(grid_size) + arena_round(grid_size * sizeof(int)) +
+                     arena_round(cells * sizeof(int)) + body_slots * sizeof(Point) +
+                     32 * ARENA_ALIGN;
+    if (!arena_init(&g->arena, reserve)) return false;
+
+    // Fresh arena pages read as zero: an empty grid and an unbuilt free set
+    g->occupancy = (unsigned char *)arena_alloc(&g->arena, grid_size);
+    g->free_pos = (int *)arena_alloc(&g->arena, grid_size * sizeof(int));
+    g->free_cells = (int *)arena_alloc(&g->arena, cells * sizeof(int));
+    g->free_count = (int)cells;
+    g->snake.capacity = 0;
+    if (!g->occupancy || !g->free_pos || !g->free_cells ||
+        !grow_body(g, INITIAL_BODY_CAPACITY)) {
+        game_free(g);
+        return false;
+    }
+
+    init_snake(g);
+    place_food(g);
+    return true;
+}
+
+/*
+ * Functionality: Restarts g as a fresh game with a new seed, keeping its pit size and
+ * memory: only the cells the old snake covered are cleared and the largest body ring is
+ * kept, so replaying games back to back allocates nothing. The result plays exactly like
+ * game_init() with the same seed. The win length goes back to the default.
+ */
+void game_reset(GameState *g, uint64_t seed) {
+    Snake *snake = &g->snake;
+    for (int i = 0; i < snake->length; i++) {
+        Point *seg = snake_segment(g, i);
+        g->occupancy[grid_cell(g, seg->x, seg->y)] = 0; // Also a head left on the border
+    }
+    if (g->free_set_ready) {
+        memset(g->free_pos, 0, (size_t)(g->pit_height + 2) * g->grid_stride * sizeof(int));
+        g->free_set_ready = false;
+    }
+    g->free_count = g->pit_height * g->pit_width;
+    g->game_over = false;
+    g->victory = false;
+    g->ticks = 0;
+    g->seed = seed;
+    rng_seed(&g->rng, seed);
+    snake->max_length = g->pit_height + g->pit_width;
+
+    init_snake(g);
+    place_food(g);
+}
+
+/*
+ * Functionality: Parses "HxW" into a pit size. Returns false if malformed or out of range.
+ */
+bool parse_pit_size(const char *arg, int *height, int *width) {
+    int h, w;
+    char extra;
+    if (sscanf(arg, "%dx%d%c", &h, &w, &extra) != 2) return false;
+    if (h < MIN_PIT_SIDE || h > MAX_PIT_SIDE || w < MIN_PIT_SIDE || w > MAX_PIT_SIDE) {
+        return false;
+    }
+    *height = h;
+    *width = w;
+    return true;
+}
+
+/*
+ * Functionality: Sets the length that wins the game, clamped to what the pit can hold.
+ */
+void game_set_target_length(GameState *g, int length) {
+    int cells = g->pit_height * g->pit_width;
+    if (length > cells) length = cells;
+    if (length <= g->snake.length) length = g->snake.length + 1;
+    g->snake.max_length = length;
+}
+
+/*
+ * Functionality: Replaces the snake with the given segments (0 = head), growing the ring if
+ * needed, and rebuilds its grid cells. The food is left alone. Used to set up positions
+ * directly, e.g. for benchmarks and restoring snapshots. Returns false if out of memory.
+ */
+bool game_load_snake(GameState *g, const Point *segments, int length, Direction dir) {
+    Snake *snake = &g->snake;
+
+    // Take the old body off the grid
+    for (int i = 0; i < snake->length; i++) {
+        Point *seg = snake_segment(g, i);
+        vacate_cell(g, grid_cell(g, seg->x, seg->y));
+    }
+    snake->length = 0;
+
+    int capacity = snake->capacity;
+    while (capacity < length + 1) capacity *= 2;
+    if (capacity != snake->capacity && !grow_body(g, capacity)) return false;
+
+    snake->head = 0;
+    snake->length = length;
+    snake->dir = dir;
+    for (int i = 0; i < length; i++) {
+        snake->body[i] = segments[i];
+        occupy_cell(g, grid_cell(g, segments[i].x, segments[i].y), true);
+    }
+    return true;
+}
+
+/*
+ * Functionality: Replaces the free-cell set with the given cells in that order and marks it
+ * built, so food placement continues exactly as in the game the order came from. The cells
+ * must be exactly the empty pit cells. Used when restoring snapshots. Returns false if
+ * they are not.
+ */
+bool game_load_free_set(GameState *g, const int *cells, int count) {
+    if (count != g->free_count) return false;
+    memset(g->free_pos, 0, (size_t)(g->pit_height + 2) * g->grid_stride * sizeof(int));
+    for (int i = 0; i < count; i++) {
+        int cell = cells[i];
+        int x = cell % g->grid_stride, y = cell / g->grid_stride;
+        if (!in_pit(g, x, y) || g->occupancy[cell] != 0 || g->free_pos[cell] != 0) {
+            g->free_set_ready = false;
+            return false;
+        }
+        g->free_cells[i] = cell;
+        g->free_pos[cell] = i + 1;
+    }
+    g->free_set_ready = true;
+    return true;
+}
+
+/*
+ * Functionality: Releases the memory owned by a game.
+ */
+void game_free(GameState *g) {
+    arena_free(&g->arena);
+    g->snake.body = NULL;
+    g->occupancy = NULL;
+    g->free_cells = NULL;
+    g->free_pos = NULL;
+}
+
+/*
+ * Functionality: Checks if a point overlaps with the snake body.
+ */
+bool is_snake_position(const GameState *g, int x, int y) {
+    if (!in_pit(g, x, y)) {
+        return false;
+    }
+    return g->occupancy[grid_cell(g, x, y)] != 0;
+}
+
+/*
+ * Functionality: Places food at a random location inside the playable area, avoiding snake body.
+ * While the board is sparse a few random picks almost always land on an empty cell; once
+ * they miss, the free-cell set is built and every later pick is a single O(1) draw from
+ * it, so placement always succeeds while any cell is empty.
+ */
+static void pick_food_cell(GameState *g) {
+    if (g->free_count == 0) {
+        // Board is full: park the food outside the pit
+        g->food.x = -1;
+        g->food.y = -1;
+        return;
+    }
+
+    if (!g->free_set_ready) {
+        for (int i = 0; i < FOOD_SAMPLE_TRIES; i++) {
+            int x = (int)rng_below(&g->rng, (uint32_t)g->pit_width) + 1;
+            int y = (int)rng_below(&g->rng, (uint32_t)g->pit_height) + 1;
+            if (g->occupancy[grid_cell(g, x, y)] == 0) {
+                g->food.x = x;
+                g->food.y = y;
+                return;
+            }
+        }
+        build_free_set(g);
+    }
+
+    int cell = g->free_cells[rng_below(&g->rng, (uint32_t)g->free_count)];
+    g->food.y = cell / g->grid_stride;
+    g->food.x = cell % g->grid_stride;
+}
+
+/*
+ * Functionality: Places the next food; see pick_food_cell().
+ */
+void place_food(GameState *g) {
+    TRACE_BEGIN(place_food);
+    pick_food_cell(g);
+    TRACE_END(place_food);
+}
+
+/*
+ * Functionality: Checks if snake collides with walls or itself. Returns true if collision detected.
+ */
+bool check_collision(const GameState *g) {
+    TRACE_BEGIN(check_collision);
+    Point head = *snake_segment(g, 0);
+
+    // Check wall collision in window-local coords (valid range: 1..pit_width / 1..pit_height),
+    // then self collision: the head's cell is shared with another segment
+    bool hit = !in_pit(g, head.x, head.y) || g->occupancy[grid_cell(g, head.x, head.y)] > 1;
+
+    TRACE_END(check_collision);
+    return hit;
+}
+
+/*
+ * Functionality: Checks if snake has reached win condition (length = half perimeter).
+ */
+bool check_win(const GameState *g) {
+    return g->snake.length >= g->snake.max_length;
+}
+
+/*
+ * Functionality: Commits a move whose new head and food test are already known: vacates
+ * the tail unless the snake ate, claims the new head cell and places new food on growth.
+ * Shared by update_snake() and the batched stepper, which computes heads in bulk.
+ */
+void game_advance(GameState *g, Point new_head, bool ate) {
+    Snake *snake = &g->snake;
+
+    // Vacate the tail cell first so the head may follow it into that cell
+    if (!ate) {
+        Point *tail = snake_segment(g, snake->length - 1);
+        vacate_cell(g, grid_cell(g, tail->x, tail->y));
+    }
+
+    // Growing needs a free slot for the new head; double the ring when it is full.
+    // The arena holds every ring up to a full pit, so this cannot run out.
+    if (ate && snake->length == snake->capacity) {
+        grow_body(g, snake->capacity * 2);
+    }
+
+    // Claim the slot in front of the current head
+    snake->head = (snake->head == 0) ? snake->capacity - 1 : snake->head - 1;
+    snake->body[snake->head] = new_head;
+    occupy_cell(g, grid_cell(g, new_head.x, new_head.y), in_pit(g, new_head.x, new_head.y));
+
+    // Check if food is consumed
+    if (ate) {
+        // Grow snake: keep the old tail by extending the length
+        snake->length++;
+        // Place new food
+        place_food(g);
+    }
+    // Otherwise the old tail simply falls off the end of the ring
+}
+
+/*
+ * Functionality: Updates snake position based on current direction.
+ * Only the new head slot is written; the tail is dropped by shrinking the
+ * ring, or kept when food is eaten, so each move is O(1) regardless of length.
+ */
+void update_snake(GameState *g) {
+    TRACE_BEGIN(update_snake);
+    Snake *snake = &g->snake;
+    Point new_head = *snake_segment(g, 0);
+
+    // Move head based on direction
+    switch (snake->dir) {
+        case UP:
+            new_head.y--;
+            break;
+        case DOWN:
+            new_head.y++;
+            break;
+        case LEFT:
+            new_head.x--;
+            break;
+        case RIGHT:
+            new_head.x++;
+            break;
+    }
+
+    game_advance(g, new_head, new_head.x == g->food.x && new_head.y == g->food.y);
+    TRACE_END(update_snake);
+}
+
+/*
+ * Functionality: Generic step kernel, for any pit size.
+ */
+static bool step_generic(GameState *g) {
+    update_snake(g);
+    return !check_collision(g);
+}
+
+/*
+ * Defines step_<H>x<W>(), a step kernel for an H x W pit fixed at compile time. The same
+ * work as step_generic(), but the bounds checks compare against constants and grid
+ * indexing multiplies by a constant stride, which becomes a shift when W + 2 is a power
+ * of two. It must stay move-for-move identical to the generic path.
+ */
+#define DEFINE_STEP_KERNEL(H, W)                                                     \
+    static bool step_##H##x##W(GameState *g) {                                       \
+        enum { STRIDE = (W) + 2 };                                                   \
+        TRACE_BEGIN(update_snake);                                                   \
+        Snake *snake = &g->snake;                                                    \
+        Point head = snake->body[snake->head];                                       \
+        head.x += (snake->dir == RIGHT) - (snake->dir == LEFT);                      \
+        head.y += (snake->dir == DOWN) - (snake->dir == UP);                         \
+        bool ate = head.x == g->food.x && head.y == g->food.y;                       \
+        bool inside = head.x >= 1 && head.x <= (W) && head.y >= 1 && head.y <= (H);  \
+                                                                                     \
+        if (!ate) {                                                                  \
+            Point *tail = snake_segment(g, snake->length - 1);                       \
+            vacate_cell(g, tail->y * STRIDE + tail->x);                              \
+        } else if (snake->length == snake->capacity) {                               \
+            grow_body(g, snake->capacity * 2);                                       \
+        }                                                                            \
+        snake->head = (snake->head == 0 ? snake->capacity : snake->head) - 1;        \
+        snake->body[snake->head] = head;                                             \
+        int cell = head.y * STRIDE + head.x;                                         \
+        occupy_cell(g, cell, inside);                                                \
+        if (ate) {                                                                   \
+            snake->length++;                                                         \
+            place_food(g);                                                           \
+        }                                                                            \
+        TRACE_END(update_snake);                                                     \
+                                                                                     \
+        TRACE_BEGIN(check_collision);                                                \
+        bool alive = inside && g->occupancy[cell] == 1;                              \
+        TRACE_END(check_collision);                                                  \
+        return alive;                                                                \
+    }
+
+// The interactive default, the benchmark sweep and a power-of-two stride size
+DEFINE_STEP_KERNEL(20, 40)
+DEFINE_STEP_KERNEL(62, 126)
+DEFINE_STEP_KERNEL(100, 100)
+DEFINE_STEP_KERNEL(250, 250)
+DEFINE_STEP_KERNEL(1000, 1000)
+
+typedef struct {
+    int height;
+    int width;
+    StepKernel step;
+    const char *name;
+} KernelEntry;
+
+static const KernelEntry step_kernels[] = {
+    { 20, 40, step_20x40, "20x40" },
+    { 62, 126, step_62x126, "62x126" },
+    { 100, 100, step_100x100, "100x100" },
+    { 250, 250, step_250x250, "250x250" },
+    { 1000, 1000, step_1000x1000, "1000x1000" },
+};
+#define STEP_KERNEL_COUNT (int)(sizeof(step_kernels) / sizeof(step_kernels[0]))
+
+/*
+ * Functionality: Returns the step kernel specialized for a pit_height x pit_width pit, or the
+ * generic one when there is none.
+ */
+static StepKernel pick_step_kernel(int pit_height, int pit_width) {
+    for (int i = 0; i < STEP_KERNEL_COUNT; i++) {
+        if (step_kernels[i].height == pit_height && step_kernels[i].width == pit_width) {
+            return step_kernels[i].step;
+        }
+    }
+    return step_generic;
+}
+
+/*
+ * Functionality: Returns the name of the step kernel g runs with ("generic" or its size).
+ */
+const char *game_kernel_name(const GameState *g) {
+    for (int i = 0; i < STEP_KERNEL_COUNT; i++) {
+        if (step_kernels[i].step == g->step) return step_kernels[i].name;
+    }
+    return "generic";
+}
+
+/*
+ * Functionality: Turns the snake, ignoring a move straight back into its own neck.
+ */
+void game_turn(GameState *g, Direction dir) {
+    if (is_opposite(dir, g->snake.dir)) return;
+    g->snake.dir = dir;
+}
+
+/*
+ * Functionality: Advances the game by one tick with the given input direction (pass the
+ * current direction to keep going straight). Returns true while the game is still running.
+ */
+bool game_step(GameState *g, Direction input) {
+    if (g->game_over || g->victory) return false;
+
+    game_turn(g, input);
+    // Specialized kernels inline update_snake() and check_collision() with the same trace
+    // points, so their parts show up under the same names as the generic path's
+    TRACE_BEGIN(step_kernel);
+    bool alive = g->step(g);
+    TRACE_END(step_kernel);
+    g->ticks++;
+
+    // Check collisions
+    if (!alive) {
+        g->game_over = true;
+        return false;
+    }
+
+    // Check win condition
+    if (check_win(g)) {
+        g->victory = true;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,124 @@
+#ifndef GAME_H
+#define GAME_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "arena.h"
+#include "rng.h"
+
+/*
+ * Headless simulation core. Everything the rules need lives in GameState, so
+ * any number of games can run side by side without ncurses or shared globals.
+ * Coordinates are window-local: the pit spans 1..pit_width / 1..pit_height and
+ * row/column 0 and pit_height + 1 / pit_width + 1 are the border.
+ */
+
+#define MIN_PIT_SIDE 3    // Room for the starting snake
+#define MAX_PIT_SIDE 4096 // Largest supported pit side
+#define INITIAL_BODY_CAPACITY 64 // Ring slots before the first growth
+#define INITIAL_LENGTH 3  // A new game's snake
+
+// Directions
+typedef enum {
+    UP,
+    DOWN,
+    LEFT,
+    RIGHT
+} Direction;
+
+// Point structure for coordinates
+typedef struct {
+    int x;
+    int y;
+} Point;
+
+// Snake structure
+// The body is a ring buffer: body[head] is the head, and segment i (0 = head)
+// lives at body[(head + i) % capacity]. Moving writes one new head slot and
+// either drops the tail (length unchanged) or keeps it (growth). The ring
+// starts small and doubles from the game's arena as the snake grows.
+typedef struct {
+    Point *body;      // Ring buffer of body segments
+    int head;         // Ring index of the head segment
+    int length;       // Current length
+    int capacity;     // Number of slots in the ring
+    int max_length;   // Length that wins the game (half perimeter by default)
+    Direction dir;    // Current direction
+} Snake;
+
+typedef struct GameState GameState;
+
+// Moves the snake one step in its current direction and returns true unless it hit a
+// wall or itself: update_snake() plus check_collision(), possibly specialized
+typedef bool (*StepKernel)(GameState *g);
+
+// Complete state of one game
+struct GameState {
+    int pit_height;   // playable area rows
+    int pit_width;    // playable area cols
+    Snake snake;
+    Point food;       // (-1, -1) once the board is full
+    bool game_over;
+    bool victory;
+    long ticks;       // Moves simulated so far
+    uint64_t seed;    // Seed the game was started with, enough to reproduce it
+    Rng rng;          // Private PRNG, so games never share random state
+    // Occupancy grid: one byte per cell counting snake segments on it, including
+    // a one-cell ring for the border so a head that hits the wall stays in bounds.
+    unsigned char *occupancy;
+    int grid_stride;  // cells per grid row (pit_width + 2)
+    // Free-cell set: a dense array of the empty pit cells plus each grid cell's
+    // position in it plus one (0 when occupied or border), updated by swap-remove.
+    // It is built the first time random sampling struggles to find an empty cell,
+    // so sparse games on huge pits never touch that memory.
+    int *free_cells;
+    int *free_pos;
+    bool free_set_ready;
+    int free_count;   // Empty pit cells, tracked even before the set is built
+    Arena arena;      // Backs the grid, free-cell set and body ring
+    StepKernel step;  // Picked by game_init() for the pit size
+};
+
+/*
+ * Functionality: Returns the occupancy grid index for window-local coords (x, y).
+ */
+static inline int grid_cell(const GameState *g, int x, int y) {
+    return y * g->grid_stride + x;
+}
+
+/*
+ * Functionality: Returns segment i of the snake (0 = head, length - 1 = tail).
+ */
+static inline Point *snake_segment(const GameState *g, int i) {
+    int idx = g->snake.head + i;
+    if (idx >= g->snake.capacity) idx -= g->snake.capacity;
+    return &g->snake.body[idx];
+}
+
+/*
+ * Functionality: Returns true if a and b point in opposite directions.
+ */
+static inline bool is_opposite(Direction a, Direction b) {
+    return (a == UP && b == DOWN) || (a == DOWN && b == UP) ||
+           (a == LEFT && b == RIGHT) || (a == RIGHT && b == LEFT);
+}
+
+bool parse_pit_size(const char *arg, int *height, int *width);
+bool game_init(GameState *g, int pit_height, int pit_width, uint64_t seed);
+void game_reset(GameState *g, uint64_t seed);
+void game_set_target_length(GameState *g, int length);
+bool game_load_snake(GameState *g, const Point *segments, int length, Direction dir);
+bool game_load_free_set(GameState *g, const int *cells, int count);
+void game_free(GameState *g);
+bool is_snake_position(const GameState *g, int x, int y);
+void place_food(GameState *g);
+void game_advance(GameState *g, Point new_head, bool ate);
+void update_snake(GameState *g);
+bool check_collision(const GameState *g);
+bool check_win(const GameState *g);
+void game_turn(GameState *g, Direction dir);
+const char *game_kernel_name(const GameState *g);
+bool game_step(GameState *g, Direction input);
+
+#endif
@@ -0,0 +1,240 @@
+#define _POSIX_C_SOURCE 200809L // clock_gettime, getopt
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "alloc.h"
+#include "ansi.h"
+#include "game.h"
+#include "ai.h"
+#include "replay.h"
+
+/*
+ * Headless driver: plays games back to back with an autopilot policy and
+ * reports simulation throughput and peak memory. Links only the core, never
+ * ncurses, so it handles pits far larger than any terminal (up to
+ * MAX_PIT_SIDE on a side).
+ *
+ * With -p it instead re-simulates replay logs at full speed, checks each ends
+ * with the recorded length, and prints the per-game results.
+ *
+ * With -w it plays one game at tick_ms per tick and streams it to stdout through
+ * the raw ANSI renderer (see ansi.h), for watching over a pipe or socket, then
+ * reports the bytes sent per frame on stderr.
+ *
+ * -a lookahead searches LOOKAHEAD_DEFAULT_DEPTH plies on the calling thread;
+ * snake_sim has the knobs for deeper or parallel searches.
+ *
+ * Usage: snake_headless [-s HxW] [-l length] [-a greedy|bfs|cycle|lookahead] [-w tick_ms]
+ *                       [ticks] [seed]
+ *        snake_headless -p replay...
+ */
+
+/*
+ * Functionality: Returns the monotonic clock in seconds.
+ */
+static double now_sec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+ * Functionality: Replays each log file and prints its outcome. Returns the process exit
+ * status: 0 if every log loaded and reproduced its recorded result.
+ */
+static int play_replays(int count, char **paths) {
+    int status = 0;
+    long total_ticks = 0;
+    double start = now_sec();
+
+    for (int i = 0; i < count; i++) {
+        ReplayHeader header;
+        size_t size;
+        uint8_t *entries = replay_load(paths[i], &header, &size);
+        if (!entries) {
+            fprintf(stderr, "%s: not a readable replay\n", paths[i]);
+            status = 1;
+            continue;
+        }
+
+        GameState game;
+        ReplayReader reader;
+        replay_reader_init(&reader, entries, size);
+        if (!replay_start(&game, &header)) {
+            fprintf(stderr, "%s: cannot start a %dx%d game\n", paths[i], header.pit_height, header.pit_width);
+            free(entries);
+            status = 1;
+            continue;
+        }
+        bool ok = replay_play(&game, &reader, &header, header.ticks) &&
+                  game.ticks == header.ticks && game.snake.length == header.final_length;
+
+        printf("%s pit=%dx%d seed=%llu ticks=%ld length=%d result=%s%s\n", paths[i],
+               header.pit_height, header.pit_width, (unsigned long long)header.seed, game.ticks,
+               game.snake.length, game.victory ? "win" : game.game_over ? "loss" : "quit",
+               ok ? "" : " MISMATCH");
+        if (!ok) status = 1;
+        total_ticks += game.ticks;
+        game_free(&game);
+        free(entries);
+    }
+
+    double elapsed = now_sec() - start;
+    printf("replays=%d ticks=%ld seconds=%.3f ticks_per_sec=%.0f\n", count, total_ticks, elapsed,
+           elapsed > 0 ? total_ticks / elapsed : 0.0);
+    return status;
+}
+
+/*
+ * Functionality: Plays game g to the end (or max_ticks) with the given policy, sleeping
+ * tick_ms between ticks, and streams every tick's frame to stdout. Returns the process
+ * exit status.
+ */
+static int watch_game(GameState *g, Policy policy, Pathfinder *pf, const CycleTable *cycle,
+                      Lookahead *la, long max_ticks, int tick_ms) {
+    int rows = 24, cols = 80;
+    struct winsize ws;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_row > 0 && ws.ws_col > 0) {
+        rows = ws.ws_row;
+        cols = ws.ws_col;
+    }
+    AnsiRenderer screen;
+    if (!ansi_open(&screen, STDOUT_FILENO, rows, cols, g->pit_height, g->pit_width)) {
+        fprintf(stderr, "Cannot render to a %dx%d terminal\n", rows, cols);
+        return 1;
+    }
+
+    struct timespec tick = { tick_ms / 1000, (long)(tick_ms % 1000) * 1000000L };
+    ansi_draw_full_frame(&screen, g);
+    bool ok = ansi_present(&screen);
+    bool alive = true;
+    while (ok && alive && g->ticks < max_ticks) {
+        if (tick_ms > 0) nanosleep(&tick, NULL);
+        Point old_head = *snake_segment(g, 0);
+        Point old_tail = *snake_segment(g, g->snake.length - 1);
+        int old_length = g->snake.length;
+        Point old_food = g->food;
+        alive = game_step(g, policy_direction(policy, pf, cycle, la, g));
+        ansi_draw_changes(&screen, g, old_head, old_tail, old_length, old_food);
+        ok = ansi_present(&screen);
+    }
+
+    long frames = screen.frames;
+    long long bytes = screen.bytes;
+    ansi_close(&screen);
+    fprintf(stderr, "ticks=%ld length=%d result=%s frames=%ld bytes=%lld bytes_per_frame=%.1f\n",
+            g->ticks, g->snake.length, g->victory ? "win" : g->game_over ? "loss" : "quit",
+            frames, bytes, frames > 0 ? (double)bytes / frames : 0.0);
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char **argv) {
+    int pit_height = 20, pit_width = 40;
+    int target_length = 0; // 0 = half perimeter
+    bool replay = false;
+    int watch_ms = -1; // -1 = not watching
+    Policy policy = POLICY_GREEDY;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "s:l:pa:w:")) != -1) {
+        switch (opt) {
+            case 's':
+                if (!parse_pit_size(optarg, &pit_height, &pit_width)) {
+                    fprintf(stderr, "Bad pit size '%s' (HxW, %d..%d per side)\n",
+                            optarg, MIN_PIT_SIDE, MAX_PIT_SIDE);
+                    return 1;
+                }
+                break;
+            case 'l':
+                target_length = atoi(optarg);
+                break;
+            case 'p':
+                replay = true;
+                break;
+            case 'w':
+                watch_ms = atoi(optarg);
+                if (watch_ms < 0) watch_ms = 0;
+                break;
+            case 'a':
+                if (!parse_policy(optarg, &policy)) {
+                    fprintf(stderr, "Unknown policy '%s' (greedy, bfs, cycle or lookahead)\n", optarg);
+                    return 1;
+                }
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-s HxW] [-l length] [-a greedy|bfs|cycle|lookahead] [-w tick_ms] [ticks] [seed]\n"
+                                "       %s -p replay...\n", argv[0], argv[0]);
+                return 1;
+        }
+    }
+    if (replay) return play_replays(argc - optind, argv + optind);
+
+    long total_ticks = optind < argc ? atol(argv[optind]) : 10000000L;
+    uint64_t seed = optind + 1 < argc ? strtoull(argv[optind + 1], NULL, 10) : 1;
+
+    GameState game;
+    Pathfinder pathfinder;
+    CycleTable cycle = {0};
+    Lookahead lookahead;
+    long ticks = 0, games = 0, wins = 0;
+    if (!pathfinder_init(&pathfinder, pit_height, pit_width)) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    if (policy == POLICY_CYCLE && !cycle_table_init(&cycle, pit_height, pit_width, default_cache_dir())) {
+        fprintf(stderr, "No Hamiltonian cycle for a %dx%d pit (one side must be even)\n",
+                pit_height, pit_width);
+        return 1;
+    }
+    if (policy == POLICY_LOOKAHEAD &&
+        !lookahead_init(&lookahead, pit_height, pit_width, LOOKAHEAD_DEFAULT_DEPTH, 1, 0)) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    Lookahead *la = policy == POLICY_LOOKAHEAD ? &lookahead : NULL;
+    double start = now_sec();
+
+    if (!game_init(&game, pit_height, pit_width, seed)) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    if (watch_ms >= 0) {
+        if (target_length > 0) game_set_target_length(&game, target_length);
+        int status = watch_game(&game, policy, &pathfinder, &cycle, la, total_ticks, watch_ms);
+        game_free(&game);
+        pathfinder_free(&pathfinder);
+        cycle_table_free(&cycle);
+        if (la) lookahead_free(la);
+        return status;
+    }
+    long mark = alloc_mark();
+    while (ticks < total_ticks) {
+        if (games > 0) game_reset(&game, seed + (uint64_t)games);
+        if (target_length > 0) game_set_target_length(&game, target_length);
+        pathfinder_reset(&pathfinder);
+        while (ticks + game.ticks < total_ticks &&
+               game_step(&game, policy_direction(policy, &pathfinder, &cycle, la, &game))) {
+            alloc_check(mark, "snake_headless");
+        }
+        ticks += game.ticks;
+        wins += game.victory;
+        games++;
+    }
+    alloc_check(mark, "snake_headless");
+    game_free(&game);
+
+    double elapsed = now_sec() - start;
+    pathfinder_free(&pathfinder);
+    cycle_table_free(&cycle);
+    if (la) lookahead_free(la);
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    printf("pit=%dx%d ticks=%ld games=%ld wins=%ld seconds=%.3f ticks_per_sec=%.0f max_rss_kb=%ld\n",
+           pit_height, pit_width, ticks, games, wins, elapsed, elapsed > 0 ? ticks / elapsed : 0.0,
+           usage.ru_maxrss);
+    return 0;
+}
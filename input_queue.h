@@ -0,0 +1,54 @@
+#ifndef INPUT_QUEUE_H
+#define INPUT_QUEUE_H
+
+#include <stdbool.h>
+
+#include "game.h"
+
+/*
+ * Single-producer single-consumer ring of turn requests. The producer (the
+ * key drain, or an input thread) only writes tail and the consumer (the tick)
+ * only writes head; each publishes with a release store that the other side
+ * reads with an acquire load, so no locks are needed. Both indices run freely
+ * and are masked on use, so head == tail means empty.
+ */
+
+#define INPUT_QUEUE_SIZE 8 // Queued turns at most; must be a power of two
+
+typedef struct {
+    Direction dir;
+    long long time_ns; // When the key was read, for latency tracking
+} InputEvent;
+
+typedef struct {
+    InputEvent events[INPUT_QUEUE_SIZE];
+    unsigned head;     // Next slot to pop (consumer)
+    char pad[64];      // Keeps the indices on separate cache lines
+    unsigned tail;     // Next slot to fill (producer)
+} InputQueue;
+
+/*
+ * Functionality: Appends an event. Returns false, dropping it, if the queue is full.
+ */
+static inline bool input_push(InputQueue *q, InputEvent ev) {
+    unsigned tail = __atomic_load_n(&q->tail, __ATOMIC_RELAXED);
+    unsigned head = __atomic_load_n(&q->head, __ATOMIC_ACQUIRE);
+    if (tail - head == INPUT_QUEUE_SIZE) return false;
+    q->events[tail & (INPUT_QUEUE_SIZE - 1)] = ev;
+    __atomic_store_n(&q->tail, tail + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+/*
+ * Functionality: Removes the oldest event into *ev. Returns false if the queue is empty.
+ */
+static inline bool input_pop(InputQueue *q, InputEvent *ev) {
+    unsigned head = __atomic_load_n(&q->head, __ATOMIC_RELAXED);
+    unsigned tail = __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE);
+    if (head == tail) return false;
+    *ev = q->events[head & (INPUT_QUEUE_SIZE - 1)];
+    __atomic_store_n(&q->head, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+#endif
@@ -0,0 +1,529 @@
+#define _POSIX_C_SOURCE 200809L // clock_gettime
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "lookahead.h"
+#include "rng.h"
+
+#define LOOKAHEAD_WIN 1000000000    // Reaching the target length
+#define LOOKAHEAD_LOSS (-1000000000) // Hitting a wall or the body
+#define LOOKAHEAD_HASTE 1000        // Per remaining ply: win sooner, die later
+#define LOOKAHEAD_FOOD 1000         // Per food eaten, times the plies still to go
+#define LOOKAHEAD_TRAPPED (-1000000) // A leaf whose head is probably boxed in ...
+#define LOOKAHEAD_SPACE 100         // ... less this per free cell it can reach
+#define DEADLINE_CHECK 63           // Positions between clock reads (a power of two less 1)
+#define ZOBRIST_SEED 0x5A0B217C0FFEEULL
+#define ZOBRIST_HEAD 4              // Key kinds per cell: 0-3 a segment whose next one is
+#define ZOBRIST_FOOD 5              // that Direction away, then the head and the food
+#define ZOBRIST_KINDS 6
+
+// The three moves from a direction, straight first: reversing runs into the neck
+static const Direction turns[4][3] = {
+    [UP] = { UP, LEFT, RIGHT },
+    [DOWN] = { DOWN, RIGHT, LEFT },
+    [LEFT] = { LEFT, DOWN, UP },
+    [RIGHT] = { RIGHT, UP, DOWN },
+};
+
+// Everything a move changed, so it can be undone
+typedef struct {
+    int to;
+    int tail;
+    int food;
+    uint64_t key;
+    uint64_t check;
+    Direction dir;
+    bool ate;
+} Undo;
+
+/*
+ * Functionality: Returns the monotonic clock in nanoseconds.
+ */
+static long long now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/*
+ * Functionality: Toggles the Zobrist keys of one kind for grid cell cell in both of the
+ * board's hashes.
+ */
+static inline void toggle_key(const Lookahead *la, SearchBoard *b, int kind, int cell) {
+    const uint64_t *z = &la->zobrist[((size_t)cell * ZOBRIST_KINDS + kind) * 2];
+    b->key ^= z[0];
+    b->check ^= z[1];
+}
+
+/*
+ * Functionality: Returns the direction of the step from grid cell from to its neighbour to.
+ */
+static inline Direction step_dir(const Lookahead *la, int from, int to) {
+    Direction d = UP;
+    while (from + la->delta[d] != to) d++;
+    return d;
+}
+
+/*
+ * Functionality: Returns the grid cell of the board's tail.
+ */
+static inline int tail_cell(const SearchBoard *b) {
+    int idx = b->head + b->length - 1;
+    if (idx >= b->capacity) idx -= b->capacity;
+    return b->body[idx];
+}
+
+/*
+ * Functionality: Moves the board's head one step in dir, eating if the food is there.
+ * Returns false, leaving the board untouched, if that hits a wall or the body.
+ */
+static bool apply_move(const Lookahead *la, SearchBoard *b, Direction dir, Undo *u) {
+    int from = b->body[b->head];
+    int to = from + la->delta[dir];
+    int tail = tail_cell(b);
+    bool ate = to == b->food;
+    // The tail cell frees up this tick unless the snake eats
+    if (b->occupancy[to] && (to != tail || ate)) return false;
+
+    u->to = to;
+    u->tail = tail;
+    u->food = b->food;
+    u->key = b->key;
+    u->check = b->check;
+    u->dir = b->dir;
+    u->ate = ate;
+
+    toggle_key(la, b, ZOBRIST_HEAD, from);
+    toggle_key(la, b, ZOBRIST_HEAD, to);
+    toggle_key(la, b, step_dir(la, to, from), to);
+    if (!ate) {
+        // The segment before the tail becomes the tail: its link to the old one goes
+        int idx = b->head + b->length - 2;
+        if (idx >= b->capacity) idx -= b->capacity;
+        int before = b->body[idx];
+        toggle_key(la, b, step_dir(la, before, tail), before);
+        b->occupancy[tail]--;
+    } else {
+        toggle_key(la, b, ZOBRIST_FOOD, b->food);
+        b->food = -1; // Where the next one appears is anyone's guess
+        b->length++;
+    }
+    b->head = b->head == 0 ? b->capacity - 1 : b->head - 1;
+    b->body[b->head] = to;
+    b->occupancy[to]++;
+    b->dir = dir;
+    return true;
+}
+
+/*
+ * Functionality: Reverts the move u recorded.
+ */
+static void undo_move(SearchBoard *b, const Undo *u) {
+    b->occupancy[u->to]--;
+    b->head = b->head == b->capacity - 1 ? 0 : b->head + 1;
+    if (u->ate) {
+        b->length--;
+    } else {
+        b->occupancy[u->tail]++;
+    }
+    b->food = u->food;
+    b->key = u->key;
+    b->check = u->check;
+    b->dir = u->dir;
+}
+
+/*
+ * Functionality: Computes the board's two Zobrist hashes from scratch. Each segment but the
+ * tail is keyed by its cell and the direction to the next one, so the hashes follow the
+ * body's order and not just the cells it covers.
+ */
+static void set_board_key(const Lookahead *la, SearchBoard *b) {
+    b->key = la->length_key[0] * (uint64_t)b->max_length;
+    b->check = la->length_key[1] * (uint64_t)b->max_length;
+    for (int i = 0; i + 1 < b->length; i++) {
+        int cell = b->body[(b->head + i) % b->capacity];
+        int next = b->body[(b->head + i + 1) % b->capacity];
+        toggle_key(la, b, step_dir(la, cell, next), cell);
+    }
+    toggle_key(la, b, ZOBRIST_HEAD, b->body[b->head]);
+    if (b->food >= 0) toggle_key(la, b, ZOBRIST_FOOD, b->food);
+}
+
+/*
+ * Functionality: Returns the grid cell of a point, or -1 for the (-1, -1) "no food" marker.
+ */
+static int point_cell(const Lookahead *la, Point p) {
+    return p.x > 0 ? p.y * la->grid_stride + p.x : -1;
+}
+
+/*
+ * Functionality: Brings board b to g's state: by applying its last move when b shows the
+ * tick before, else by copying the whole snake (a new game).
+ */
+static void sync_board(const Lookahead *la, SearchBoard *b, const GameState *g) {
+    if (b->synced && b->seed == g->seed && b->ticks == g->ticks) return;
+    Point head = *snake_segment(g, 0);
+    if (b->synced && b->seed == g->seed && b->ticks + 1 == g->ticks) {
+        // Replay the move, which eats the same food the game's did, then take the new food
+        Undo u;
+        if (apply_move(la, b, g->snake.dir, &u) && b->body[b->head] == point_cell(la, head) &&
+            b->length == g->snake.length) {
+            if (b->food >= 0) toggle_key(la, b, ZOBRIST_FOOD, b->food);
+            b->food = point_cell(la, g->food);
+            if (b->food >= 0) toggle_key(la, b, ZOBRIST_FOOD, b->food);
+            b->ticks = g->ticks;
+            return;
+        }
+    }
+
+    size_t grid_size = (size_t)(la->pit_height + 2) * la->grid_stride;
+    memset(b->occupancy, 1, grid_size);
+    for (int y = 1; y <= la->pit_height; y++) {
+        memset(b->occupancy + (size_t)y * la->grid_stride + 1, 0, la->pit_width);
+    }
+    b->head = 0;
+    b->length = g->snake.length;
+    for (int i = 0; i < b->length; i++) {
+        Point *p = snake_segment(g, i);
+        b->body[i] = point_cell(la, *p);
+        b->occupancy[b->body[i]]++;
+    }
+    b->max_length = g->snake.max_length;
+    b->dir = g->snake.dir;
+    b->food = point_cell(la, g->food);
+    set_board_key(la, b);
+    b->seed = g->seed;
+    b->ticks = g->ticks;
+    b->synced = true;
+}
+
+/*
+ * Functionality: Scores a leaf: closer to the food is better, and a head that can reach
+ * neither its tail, the one cell sure to open up, nor twice the snake's length in free
+ * cells is probably trapped; the less room the worse.
+ */
+static int evaluate(const Lookahead *la, SearchBoard *b) {
+    int stride = la->grid_stride;
+    int head = b->body[b->head], tail = tail_cell(b);
+    int score = 0;
+    if (b->food >= 0) {
+        score -= abs(head % stride - b->food % stride) + abs(head / stride - b->food / stride);
+    }
+
+    if (++b->generation == 0) {
+        memset(b->visited, 0, (size_t)(la->pit_height + 2) * stride * sizeof(uint32_t));
+        b->generation = 1;
+    }
+    uint32_t stamp = b->generation;
+    int count = 0, front = 0, back = 0;
+    bool reached = false;
+    b->queue[back++] = head;
+    b->visited[head] = stamp;
+    while (front < back && !reached) {
+        int cell = b->queue[front++];
+        for (int d = UP; d <= RIGHT; d++) {
+            int next = cell + la->delta[d];
+            if (b->visited[next] == stamp) continue;
+            if (next == tail) {
+                reached = true;
+                break;
+            }
+            if (b->occupancy[next]) continue;
+            b->visited[next] = stamp;
+            b->queue[back++] = next;
+            if (++count >= 2 * b->length) { // Room enough, even if the tail is far
+                reached = true;
+                break;
+            }
+        }
+    }
+    if (!reached) score += LOOKAHEAD_TRAPPED + count * LOOKAHEAD_SPACE;
+    return score;
+}
+
+/*
+ * Functionality: Looks up board b's position searched at least depth plies deep. Returns
+ * true with its value in *value on a hit.
+ */
+static bool cache_get(const Lookahead *la, const SearchBoard *b, int depth, int *value) {
+    uint64_t *entry = la->cache[b->key & la->cache_mask];
+    uint64_t key = __atomic_load_n(&entry[0], __ATOMIC_RELAXED);
+    uint64_t check = __atomic_load_n(&entry[1], __ATOMIC_RELAXED);
+    uint64_t data = __atomic_load_n(&entry[2], __ATOMIC_RELAXED);
+    // A torn entry, or another position with the same index or even the same key, fails
+    // one of the checks; data always has bit 40 set when written
+    if ((key ^ data) != b->key || (check ^ data) != b->check || !(data >> 40 & 1) ||
+        (int)(data >> 32 & 0xff) < depth) {
+        return false;
+    }
+    *value = (int)(uint32_t)data;
+    return true;
+}
+
+/*
+ * Functionality: Stores board b's position's value, searched depth plies deep.
+ */
+static void cache_put(Lookahead *la, const SearchBoard *b, int depth, int value) {
+    uint64_t *entry = la->cache[b->key & la->cache_mask];
+    uint64_t data = (uint64_t)(uint32_t)value | (uint64_t)depth << 32 | 1ULL << 40;
+    __atomic_store_n(&entry[2], data, __ATOMIC_RELAXED);
+    __atomic_store_n(&entry[0], b->key ^ data, __ATOMIC_RELAXED);
+    __atomic_store_n(&entry[1], b->check ^ data, __ATOMIC_RELAXED);
+}
+
+static int node_value(Lookahead *la, SearchBoard *b, int depth);
+
+/*
+ * Functionality: Returns the value of making move dir with depth plies (at least 1) left.
+ */
+static int move_value(Lookahead *la, SearchBoard *b, Direction dir, int depth) {
+    Undo u;
+    if (!apply_move(la, b, dir, &u)) return LOOKAHEAD_LOSS - depth * LOOKAHEAD_HASTE;
+    int value;
+    if (u.ate && b->length >= b->max_length) {
+        value = LOOKAHEAD_WIN + depth * LOOKAHEAD_HASTE;
+    } else {
+        value = (u.ate ? LOOKAHEAD_FOOD * depth : 0) + node_value(la, b, depth - 1);
+    }
+    undo_move(b, &u);
+    return value;
+}
+
+/*
+ * Functionality: Returns the value of the board's position searched depth plies deep: the
+ * best of its three moves, from the cache when it has it. Returns 0 once the round is
+ * aborted; such values are never cached or used.
+ */
+static int node_value(Lookahead *la, SearchBoard *b, int depth) {
+    if (depth == 0) return evaluate(la, b);
+    if (la->deadline_ns && (++b->nodes & DEADLINE_CHECK) == 0 && now_ns() > la->deadline_ns) {
+        __atomic_store_n(&la->aborted, 1, __ATOMIC_RELAXED);
+    }
+    if (__atomic_load_n(&la->aborted, __ATOMIC_RELAXED)) return 0;
+
+    int best;
+    if (cache_get(la, b, depth, &best)) return best;
+    best = INT_MIN;
+    for (int t = 0; t < 3; t++) {
+        int value = move_value(la, b, turns[b->dir][t], depth);
+        if (value > best) best = value;
+    }
+    if (__atomic_load_n(&la->aborted, __ATOMIC_RELAXED)) return 0;
+    cache_put(la, b, depth, best);
+    return best;
+}
+
+/*
+ * Functionality: Returns the value of task task: first move task / 3 then second move
+ * task % 3, searched to round_depth plies in all.
+ */
+static int task_value(Lookahead *la, SearchBoard *b, int task, int depth) {
+    Undo u;
+    if (!apply_move(la, b, turns[b->dir][task / 3], &u)) {
+        return LOOKAHEAD_LOSS - depth * LOOKAHEAD_HASTE;
+    }
+    int value;
+    if (u.ate && b->length >= b->max_length) {
+        value = LOOKAHEAD_WIN + depth * LOOKAHEAD_HASTE;
+    } else {
+        value = (u.ate ? LOOKAHEAD_FOOD * depth : 0) +
+                move_value(la, b, turns[b->dir][task % 3], depth - 1);
+    }
+    undo_move(b, &u);
+    return value;
+}
+
+/*
+ * Functionality: Takes the round's tasks one at a time until none are left, searching them
+ * on board b.
+ */
+static void run_tasks(Lookahead *la, SearchBoard *b) {
+    sync_board(la, b, la->game);
+    for (;;) {
+        int task = __atomic_fetch_add(&la->next_task, 1, __ATOMIC_RELAXED);
+        if (task >= LOOKAHEAD_TASKS) return;
+        la->values[task] = task_value(la, b, task, la->round_depth);
+    }
+}
+
+/*
+ * Functionality: Pool thread body: waits for a round, does its share, repeats until stopped.
+ */
+static void *search_main(void *arg) {
+    SearchThread *t = (SearchThread *)arg;
+    Lookahead *la = t->la;
+    long seen = 0;
+    for (;;) {
+        pthread_mutex_lock(&la->lock);
+        while (la->round == seen && !la->stop) pthread_cond_wait(&la->wake, &la->lock);
+        if (la->stop) {
+            pthread_mutex_unlock(&la->lock);
+            return NULL;
+        }
+        seen = la->round;
+        pthread_mutex_unlock(&la->lock);
+
+        run_tasks(la, &la->boards[t->index]);
+
+        pthread_mutex_lock(&la->lock);
+        la->finished++;
+        pthread_cond_signal(&la->done);
+        pthread_mutex_unlock(&la->lock);
+    }
+}
+
+/*
+ * Functionality: Searches g depth plies deep on every thread and waits for the result in
+ * la->values.
+ */
+static void run_round(Lookahead *la, const GameState *g, int depth) {
+    pthread_mutex_lock(&la->lock);
+    la->game = g;
+    la->round_depth = depth;
+    la->next_task = 0;
+    la->finished = 0;
+    la->round++;
+    pthread_cond_broadcast(&la->wake);
+    pthread_mutex_unlock(&la->lock);
+
+    run_tasks(la, &la->boards[0]);
+
+    pthread_mutex_lock(&la->lock);
+    while (la->finished < la->thread_count - 1) pthread_cond_wait(&la->done, &la->lock);
+    pthread_mutex_unlock(&la->lock);
+}
+
+/*
+ * Functionality: Allocates one thread's board for the pit. Returns false if out of memory.
+ */
+static bool board_init(SearchBoard *b, int pit_height, int pit_width) {
+    size_t grid_size = (size_t)(pit_height + 2) * (pit_width + 2);
+    size_t cells = (size_t)pit_height * pit_width;
+    memset(b, 0, sizeof(*b));
+    b->capacity = (int)cells;
+    b->body = (int *)malloc(cells * sizeof(int));
+    b->occupancy = (unsigned char *)malloc(grid_size);
+    b->visited = (uint32_t *)calloc(grid_size, sizeof(uint32_t));
+    b->queue = (int *)malloc(cells * sizeof(int));
+    return b->body && b->occupancy && b->visited && b->queue;
+}
+
+/*
+ * Functionality: Sets up a lookahead autopilot for a pit_height x pit_width pit searching
+ * depth plies (clamped to LOOKAHEAD_MIN_DEPTH..LOOKAHEAD_MAX_DEPTH) on threads threads
+ * including the caller (at most LOOKAHEAD_MAX_THREADS), within budget_us microseconds a move
+ * if above 0. Every buffer and thread is set up here, so picking moves never allocates.
+ * Returns false if out of memory or a thread cannot start.
+ */
+bool lookahead_init(Lookahead *la, int pit_height, int pit_width, int depth, int threads,
+                    long budget_us) {
+    memset(la, 0, sizeof(*la));
+    la->pit_height = pit_height;
+    la->pit_width = pit_width;
+    la->grid_stride = pit_width + 2;
+    la->depth = depth < LOOKAHEAD_MIN_DEPTH ? LOOKAHEAD_MIN_DEPTH
+              : depth > LOOKAHEAD_MAX_DEPTH ? LOOKAHEAD_MAX_DEPTH : depth;
+    la->budget_ns = budget_us > 0 ? budget_us * 1000LL : 0;
+    la->delta[UP] = -la->grid_stride;
+    la->delta[DOWN] = la->grid_stride;
+    la->delta[LEFT] = -1;
+    la->delta[RIGHT] = 1;
+    pthread_mutex_init(&la->lock, NULL);
+    pthread_cond_init(&la->wake, NULL);
+    pthread_cond_init(&la->done, NULL);
+
+    size_t grid_size = (size_t)(pit_height + 2) * la->grid_stride;
+    la->zobrist = (uint64_t *)malloc(grid_size * ZOBRIST_KINDS * 2 * sizeof(uint64_t));
+    la->cache = (uint64_t (*)[3])calloc((size_t)1 << LOOKAHEAD_CACHE_BITS, sizeof(*la->cache));
+    if (!la->zobrist || !la->cache) goto fail;
+    uint64_t x = ZOBRIST_SEED;
+    for (size_t i = 0; i < grid_size * ZOBRIST_KINDS * 2; i++) {
+        la->zobrist[i] = splitmix64(&x);
+    }
+    la->length_key[0] = splitmix64(&x) | 1;
+    la->length_key[1] = splitmix64(&x) | 1;
+    la->cache_mask = ((size_t)1 << LOOKAHEAD_CACHE_BITS) - 1;
+
+    if (threads < 1) threads = 1;
+    if (threads > LOOKAHEAD_MAX_THREADS) threads = LOOKAHEAD_MAX_THREADS;
+    for (int i = 0; i < threads; i++) {
+        if (!board_init(&la->boards[i], pit_height, pit_width)) goto fail;
+    }
+    la->thread_count = 1;
+    for (int i = 1; i < threads; i++) {
+        SearchThread *t = &la->threads[i];
+        t->la = la;
+        t->index = i;
+        if (pthread_create(&t->thread, NULL, search_main, t) != 0) goto fail;
+        la->thread_count++;
+    }
+    return true;
+
+fail:
+    lookahead_free(la);
+    return false;
+}
+
+/*
+ * Functionality: Stops the pool threads and releases everything.
+ */
+void lookahead_free(Lookahead *la) {
+    pthread_mutex_lock(&la->lock);
+    la->stop = true;
+    pthread_cond_broadcast(&la->wake);
+    pthread_mutex_unlock(&la->lock);
+    for (int i = 1; i < la->thread_count; i++) {
+        pthread_join(la->threads[i].thread, NULL);
+    }
+    for (int i = 0; i < LOOKAHEAD_MAX_THREADS; i++) {
+        SearchBoard *b = &la->boards[i];
+        free(b->body);
+        free(b->occupancy);
+        free(b->visited);
+        free(b->queue);
+    }
+    free(la->zobrist);
+    free(la->cache);
+    pthread_mutex_destroy(&la->lock);
+    pthread_cond_destroy(&la->wake);
+    pthread_cond_destroy(&la->done);
+    memset(la, 0, sizeof(*la));
+}
+
+/*
+ * Functionality: Searches g's possible futures and returns the first move of the best one.
+ * Keeps the current direction when every move loses.
+ */
+Direction lookahead_direction(Lookahead *la, const GameState *g) {
+    int best[3] = {0};
+    int completed = 0;
+    long long start = la->budget_ns ? now_ns() : 0;
+    // Without a budget go straight to full depth; with one, deepen while time is left
+    for (int depth = la->budget_ns ? LOOKAHEAD_MIN_DEPTH : la->depth; depth <= la->depth; depth++) {
+        // The shallowest round always completes, so there is always a move
+        la->deadline_ns = la->budget_ns && completed > 0 ? start + la->budget_ns : 0;
+        la->aborted = 0;
+        run_round(la, g, depth);
+        if (la->aborted) break;
+        for (int m = 0; m < 3; m++) {
+            best[m] = INT_MIN;
+            for (int k = 0; k < 3; k++) {
+                if (la->values[m * 3 + k] > best[m]) best[m] = la->values[m * 3 + k];
+            }
+        }
+        completed = depth;
+        if (la->budget_ns && now_ns() - start > la->budget_ns) break;
+    }
+    la->searches++;
+    la->depth_sum += completed;
+
+    Direction dir = g->snake.dir;
+    int pick = 0;
+    for (int m = 1; m < 3; m++) {
+        if (best[m] > best[pick]) pick = m;
+    }
+    if (best[pick] > LOOKAHEAD_LOSS / 2) dir = turns[dir][pick];
+    return dir;
+}
@@ -0,0 +1,116 @@
+#ifndef LOOKAHEAD_H
+#define LOOKAHEAD_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "game.h"
+
+/*
+ * Lookahead autopilot: searches every sequence of moves up to depth ticks
+ * ahead and takes the first move of the best one, spreading the search over
+ * a small thread pool.
+ *
+ * Each thread keeps a private SearchBoard: a body ring sized for a full pit
+ * plus an occupancy grid, kept in step with the real game by applying its
+ * one move per tick (a full copy only happens when a new game starts). The
+ * search walks the tree by applying a move and undoing it again on that
+ * board, never copying state. The tree's first two plies (3 x 3 turns from
+ * the current direction) are split into nine tasks that the caller and the
+ * pool threads take in turn.
+ *
+ * Food eaten during the search is not replaced, since where the next one
+ * appears is random. A leaf scores the distance to the food and whether the
+ * head can still reach its tail (or plenty of room); eating, winning and
+ * dying score at the edge that does it, sooner counting for more.
+ *
+ * Searched positions go into a transposition cache shared by the threads,
+ * keyed by a Zobrist hash of the board (each segment's cell and the way to
+ * the next one, so two bodies over the same cells in a different order
+ * differ, plus the head, food and target length) and holding the depth they
+ * were searched to. A short snake
+ * reaches the same position by different routes; and when deepening under a
+ * budget, every round short of the last finds its positions valued by the
+ * previous tick's search, which saw them one ply deeper. Entries are written
+ * lock-free and checked against both the key and a second, independent
+ * hash, so a torn write or a colliding position reads as a miss.
+ *
+ * With a time budget the search deepens one ply at a time from 2 until the
+ * budget runs out or depth is reached, keeping the last complete depth. The
+ * result then depends on timing; without one the search is a pure function of
+ * the game and cache, and with one thread it is fully deterministic.
+ */
+
+#define LOOKAHEAD_MIN_DEPTH 2      // The two plies split into tasks
+#define LOOKAHEAD_MAX_DEPTH 32
+#define LOOKAHEAD_DEFAULT_DEPTH 6
+#define LOOKAHEAD_MAX_THREADS 9    // One per task
+#define LOOKAHEAD_TASKS 9          // 3 first moves x 3 second moves
+#define LOOKAHEAD_CACHE_BITS 18    // 2^18 cache entries, 24 bytes each
+
+typedef struct Lookahead Lookahead;
+
+// One thread's copy of the game, searched by applying and undoing moves
+typedef struct {
+    int *body;               // Ring of grid cells, body[head] is the head
+    int head;
+    int length;
+    int capacity;            // Pit cells: the longest a snake can get
+    int max_length;
+    Direction dir;
+    int food;                // Grid cell, -1 when none
+    unsigned char *occupancy; // Segments per grid cell, border cells 1
+    uint64_t key;            // Zobrist hash of the above ...
+    uint64_t check;          // ... and a second one from other keys, to confirm cache hits
+    uint32_t *visited;       // Flood-fill stamps, per grid cell
+    uint32_t generation;
+    int *queue;              // Flood-fill frontier
+    long nodes;              // Positions searched, for the deadline check
+    uint64_t seed;           // The game and tick the board shows
+    long ticks;
+    bool synced;
+} SearchBoard;
+
+typedef struct {
+    Lookahead *la;
+    int index;               // Its board in la->boards
+    pthread_t thread;
+} SearchThread;
+
+struct Lookahead {
+    int pit_height;
+    int pit_width;
+    int grid_stride;
+    int depth;               // Deepest search
+    long long budget_ns;     // Time per move, 0 for none
+    int delta[4];            // Grid offset of a step per Direction
+    uint64_t *zobrist;       // Per grid cell: link, head and food keys, a pair of each
+    uint64_t length_key[2];  // Mixed with the target length
+    uint64_t (*cache)[3];    // Transposition cache: {key ^ data, check ^ data, data} per entry
+    size_t cache_mask;
+    SearchBoard boards[LOOKAHEAD_MAX_THREADS]; // boards[0] is the caller's
+    int thread_count;        // Including the caller
+    SearchThread threads[LOOKAHEAD_MAX_THREADS];
+    pthread_mutex_t lock;    // Guards the round fields below
+    pthread_cond_t wake;     // A round started, or stop
+    pthread_cond_t done;     // A pool thread finished its share
+    const GameState *game;   // Searched this round, read-only
+    long round;
+    int round_depth;
+    int finished;            // Pool threads done with the round
+    bool stop;
+    int next_task;           // Atomic: next of the round's tasks to take
+    int aborted;             // Atomic: the budget ran out mid-round
+    long long deadline_ns;   // 0: this round runs to the end
+    int values[LOOKAHEAD_TASKS];
+    long searches;           // Moves picked ...
+    long depth_sum;          // ... and their total completed depth
+};
+
+bool lookahead_init(Lookahead *la, int pit_height, int pit_width, int depth, int threads,
+                    long budget_us);
+void lookahead_free(Lookahead *la);
+Direction lookahead_direction(Lookahead *la, const GameState *g);
+
+#endif
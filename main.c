@@ -1,55 +1,62 @@
+#define _POSIX_C_SOURCE 200809L // clock_gettime, getopt
 #include <ncurses.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <time.h>
 #include <stdbool.h>
+#include <poll.h>
+
+#include "alloc.h"
+#include "ansi.h"
+#include "game.h"
+#include "render.h"
+#include "replay.h"
+#include "metrics.h"
+#include "input_queue.h"
+#include "ai.h"
+#include "spectate.h"
+#include "trace.h"
 
 // Game Constants
-#define DELAY 50000 // Microseconds for delay
+#define TICK_NS 100000000LL // Nanoseconds per simulation tick (10 moves/sec)
+#define MAX_CATCHUP_TICKS 5 // Ticks simulated at most per wakeup before resyncing the clock
 #define MIN_ROWS 20
 #define MIN_COLS 20
-
-// Color pairs
-#define COLOR_SNAKE_HEAD 1
-#define COLOR_SNAKE_BODY 2
-#define COLOR_FOOD 3
-#define COLOR_BORDER 4
-#define COLOR_TEXT 5
-
-// Directions
-typedef enum {
-    UP,
-    DOWN,
-    LEFT,
-    RIGHT
-} Direction;
-
-// Point structure for coordinates
-typedef struct {
-    int x;
-    int y;
-} Point;
-
-// Snake structure
-typedef struct {
-    Point *body;      // Array of body segments
-    int length;       // Current length
-    int max_length;   // Maximum possible length (half perimeter)
-    Direction dir;    // Current direction
-} Snake;
+#define METRICS_HUD_NS 250000000LL // Refresh period of the metrics HUD line
+#define SPECTATOR_ROWS 24          // Terminal size frames for spectators are drawn for
+#define SPECTATOR_COLS 80
+#define MAX_SPECTATORS 64
 
 // Global variables
 int max_y = 0, max_x = 0;
-Snake snake;
-Point food;
-bool game_over = false;
-bool victory = false;
-// Game window
-WINDOW *game_win = NULL;
+GameState game;
 int pit_height = 20; // playable area rows
 int pit_width = 40;  // playable area cols
-int win_start_y = 0;
-int win_start_x = 0;
+int target_length = 0; // -l, 0 for the default
+uint64_t seed;         // Game n of the session is seeded with seed + n
+long games_played = 0; // Restarts so far
+ReplayWriter recorder; // Replay log, recording only when recorder.file is set
+
+// Frame timing, shown with the 'm' key and written to the -m stats file on exit
+Metric sim_time;        // game_step() per tick
+Metric render_time;     // Drawing plus doupdate() per frame
+Metric input_latency;   // Key read to the frame showing its effect
+Metric wake_lag;        // How late the loop woke for a due tick (poll oversleep)
+bool show_metrics = false;
+long long input_time = 0; // When the oldest key not yet on screen was read (0 = none)
+
+// Turns wait here until a tick consumes them, one per tick
+InputQueue input_queue;
+Direction last_queued; // Direction the snake will have once the queue drains
+
+bool autopilot = false; // BFS bot steers instead of the arrow keys
+Pathfinder pathfinder;
+
+// Spectators (-w port): each tick is rendered once as raw ANSI and fanned out to them
+int spectator_fd = -1; // Listening socket, -1 when nobody may watch
+Spectate spectators;
+AnsiRenderer spectator_screen;
+bool spectator_repaint = true; // Next frame repaints everything: spectators show another game
 
 /*
  * Functionality: Initializes ncurses and game settings with color support.
@@ -61,400 +68,493 @@ void init_game() {
     keypad(stdscr, TRUE);   // Enable function keys (arrows)
     curs_set(0);            // Hide cursor
     timeout(0);             // Non-blocking getch
-    
-    // Initialize colors if terminal supports it
-    if (has_colors()) {
-        start_color();
-        // Green snake head
-        init_pair(COLOR_SNAKE_HEAD, COLOR_GREEN, COLOR_BLACK);
-        // Bright green snake body
-        init_pair(COLOR_SNAKE_BODY, COLOR_GREEN, COLOR_BLACK);
-        // Red food
-        init_pair(COLOR_FOOD, COLOR_RED, COLOR_BLACK);
-        // Cyan border
-        init_pair(COLOR_BORDER, COLOR_CYAN, COLOR_BLACK);
-        // Yellow text
-        init_pair(COLOR_TEXT, COLOR_YELLOW, COLOR_BLACK);
-    }
+    init_colors();          // Color pairs, if the terminal supports them
 }
 
 /*
- * Functionality: Initializes the snake with length 3 at the center of the screen.
+ * Functionality: Cleans up ncurses before exiting.
  */
-void init_snake() {
-    // Use window-local coordinates (1..pit_height, 1..pit_width)
-    // Calculate half perimeter for win condition
-    int perimeter = 2 * (pit_height + pit_width);
-    snake.max_length = perimeter / 2;
-
-    // Allocate memory for snake body (max possible length)
-    snake.body = (Point *)malloc(snake.max_length * sizeof(Point));
-
-    // Initialize snake with length 3 at center of the pit
-    snake.length = 3;
-    int center_y = pit_height / 2 + 1; // local coords (1-based inside border)
-    int center_x = pit_width / 2 + 1;
-
-    snake.body[0].y = center_y;
-    snake.body[0].x = center_x;
-    snake.body[1].y = center_y;
-    snake.body[1].x = center_x - 1;
-    snake.body[2].y = center_y;
-    snake.body[2].x = center_x - 2;
-
-    snake.dir = RIGHT; // Initial direction
+void cleanup_game() {
+    game_free(&game); // Free allocated memory
+    pathfinder_free(&pathfinder);
+    if (spectator_fd >= 0) {
+        close(spectator_fd);
+        spectate_free(&spectators);
+        ansi_close(&spectator_screen);
+    }
+    render_close();
+    endwin(); // End ncurses mode
 }
 
 /*
- * Functionality: Draws the border around the snake pit (20x20 minimum) with color.
+ * Functionality: Sizes and centers the viewport for the current terminal. It shows the
+ * whole pit when it fits, leaving a row above for the HUD; larger pits get a
+ * terminal-sized viewport and the camera follows the head. Returns false if the
+ * terminal is too small or ncurses fails.
  */
-void draw_border() {
-    if (!game_win) return;
-    if (has_colors()) {
-        wattron(game_win, COLOR_PAIR(COLOR_BORDER));
-    }
-
-    // Draw border around game window
-    wborder(game_win, 0,0,0,0,0,0,0,0);
+bool layout_viewport() {
+    getmaxyx(stdscr, max_y, max_x);
+    if (max_y < MIN_ROWS || max_x < MIN_COLS) return false;
 
-    if (has_colors()) {
-        wattroff(game_win, COLOR_PAIR(COLOR_BORDER));
-    }
+    int win_height = pit_height + 2, win_width = pit_width + 2;
+    if (win_height > max_y - 2) win_height = max_y - 2;
+    if (win_width > max_x - 2) win_width = max_x - 2;
+    return render_open(&game, (max_y - win_height) / 2, (max_x - win_width) / 2,
+                       win_height, win_width);
 }
 
 /*
- * Functionality: Draws the snake on the screen with larger characters and color.
+ * Functionality: Displays a simple start screen and waits for user to press space.
  */
-void draw_snake() {
-    if (!game_win) return;
-
-    // Draw head with larger block character
-    // Choose head glyph based on direction
-    chtype head_glyph = '>';
-    switch (snake.dir) {
-        case UP:
-            head_glyph = '^';
-            break;
-        case DOWN:
-            head_glyph = 'v';
-            break;
-        case LEFT:
-            head_glyph = '<';
-            break;
-        case RIGHT:
-        default:
-            head_glyph = '>';
-            break;
-    }
-
-    if (has_colors()) {
-        wattron(game_win, COLOR_PAIR(COLOR_SNAKE_HEAD) | A_BOLD);
-    }
-    mvwaddch(game_win, snake.body[0].y, snake.body[0].x, head_glyph);
-    if (has_colors()) {
-        wattroff(game_win, COLOR_PAIR(COLOR_SNAKE_HEAD) | A_BOLD);
-    }
-
-    // Draw body with block characters
+void show_start_screen() {
+    clear();
+    int center_y = max_y / 2;
+    int center_x = max_x / 2;
+    
     if (has_colors()) {
-        wattron(game_win, COLOR_PAIR(COLOR_SNAKE_BODY));
-    }
-    for (int i = 1; i < snake.length; i++) {
-        mvwaddch(game_win, snake.body[i].y, snake.body[i].x, ACS_BLOCK);
+        attron(COLOR_PAIR(COLOR_TEXT) | A_BOLD);
     }
+    
+    mvprintw(center_y - 3, center_x - 10, "================");
+    mvprintw(center_y - 2, center_x - 10, "   SNAKE GAME   ");
+    mvprintw(center_y - 1, center_x - 10, "================");
+    mvprintw(center_y + 1, center_x - 15, "Use Arrow Keys to Move");
+    mvprintw(center_y + 2, center_x - 12, "Eat food to grow");
+    mvprintw(center_y + 3, center_x - 15, "To Win: Reach a length of %d", game.snake.max_length);
+    mvprintw(center_y + 5, center_x - 10, "Press SPACE to start");
+    mvprintw(center_y + 6, center_x - 8, "Press 'q' to quit");
+    
     if (has_colors()) {
-        wattroff(game_win, COLOR_PAIR(COLOR_SNAKE_BODY));
+        attroff(COLOR_PAIR(COLOR_TEXT) | A_BOLD);
     }
+    
+    refresh();
+    
+    timeout(-1); // Blocking input
+    int ch;
+    while ((ch = getch()) != ' ' && ch != 'q' && ch != 'Q');
+    timeout(0); // Back to non-blocking
 }
 
 /*
- * Functionality: Checks if a point overlaps with the snake body.
+ * Functionality: Returns the monotonic clock in nanoseconds.
  */
-bool is_snake_position(int x, int y) {
-    for (int i = 0; i < snake.length; i++) {
-        if (snake.body[i].x == x && snake.body[i].y == y) {
-            return true;
-        }
-    }
-    return false;
+long long now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
 }
 
 /*
- * Functionality: Places food at a random location inside the playable area, avoiding snake body.
+ * Functionality: Blocks until stdin is readable or the deadline (monotonic ns) passes.
  */
-void place_food() {
-    int attempts = 0;
-    int max_attempts = 100; // Prevent infinite loop
-    
-    do {
-        // Place food inside the pit (local window coords: 1..pit_height, 1..pit_width)
-        food.y = (rand() % pit_height) + 1;
-        food.x = (rand() % pit_width) + 1;
-        attempts++;
-    } while (is_snake_position(food.x, food.y) && attempts < max_attempts);
-    
+void wait_for_input(long long deadline) {
+    long long remaining = deadline - now_ns();
+    if (remaining <= 0) return;
+
+    // Round up so we never wake just before the deadline and spin
+    int timeout_ms = (int)((remaining + 999999) / 1000000);
+    struct pollfd pfd = { .fd = STDIN_FILENO, .events = POLLIN };
+    poll(&pfd, 1, timeout_ms);
 }
 
 /*
- * Functionality: Checks if snake collides with walls or itself. Returns true if collision detected.
+ * Functionality: Queues a direction key for a later tick. Keys are checked against the
+ * last queued direction rather than the current one, so UP then LEFT within one tick
+ * both land and a quick U-turn is not rejected; repeats and reversals are dropped.
  */
-bool check_collision() {
-    Point head = snake.body[0];
+void handle_turn(Direction dir) {
+    if (autopilot) return; // Arrow keys are ignored while the bot steers
+    if (dir == last_queued || is_opposite(dir, last_queued)) return;
+    InputEvent ev = { dir, now_ns() };
+    if (input_push(&input_queue, ev)) last_queued = dir;
+}
 
-    // Check wall collision in window-local coords (valid range: 1..pit_width / 1..pit_height)
-    if (head.x <= 0 || head.x > pit_width || head.y <= 0 || head.y > pit_height) {
-        return true;
-    }
-    
-    // Check self collision
-    for (int i = 1; i < snake.length; i++) {
-        if (head.x == snake.body[i].x && head.y == snake.body[i].y) {
-            return true;
-        }
+/*
+ * Functionality: Redraws the metrics HUD line: p50/p99 of each counter over its window.
+ */
+void draw_metrics() {
+    const Metric *metrics[] = { &sim_time, &render_time, &input_latency, &wake_lag };
+    const char *names[] = { "sim", "draw", "lat", "wake" };
+    char line[160], p50[16], p99[16];
+    int len = 0;
+
+    for (int i = 0; i < 4; i++) {
+        format_duration(p50, sizeof(p50), metric_percentile(metrics[i], 50));
+        format_duration(p99, sizeof(p99), metric_percentile(metrics[i], 99));
+        len += snprintf(line + len, sizeof(line) - len, "%s %s/%s ", names[i], p50, p99);
     }
-    
-    return false;
+    snprintf(line + len, sizeof(line) - len, "(p50/p99)");
+    draw_status(line);
 }
 
 /*
- * Functionality: Checks if snake has reached win condition (length = half perimeter).
+ * Functionality: Writes every counter to the stats file at path. Returns false on error.
  */
-bool check_win() {
-    return snake.length >= snake.max_length;
+bool write_stats(const char *path) {
+    FILE *f = fopen(path, "w");
+    if (!f) return false;
+    fprintf(f, "# Percentiles cover the last %d samples; times in microseconds\n", METRIC_WINDOW);
+    metric_write(f, "sim_per_tick", &sim_time);
+    metric_write(f, "render_per_frame", &render_time);
+    metric_write(f, "input_latency", &input_latency);
+    metric_write(f, "wake_lag", &wake_lag);
+    return fclose(f) == 0;
 }
 
 /*
- * Functionality: Cleans up ncurses before exiting.
+ * Functionality: Opens the spectator port and the renderer and broadcaster behind it.
+ * Returns false with a message on stderr on failure.
  */
-void cleanup_game() {
-    free(snake.body); // Free allocated memory
-    if (game_win) {
-        delwin(game_win);
-        game_win = NULL;
+bool open_spectators(int port) {
+    if (!ansi_open(&spectator_screen, -1, SPECTATOR_ROWS, SPECTATOR_COLS, pit_height, pit_width) ||
+        !spectate_init(&spectators, MAX_SPECTATORS, spectator_screen.out_cap)) {
+        fprintf(stderr, "Out of memory\n");
+        return false;
     }
-    endwin(); // End ncurses mode
+    spectator_fd = spectate_listen(port);
+    if (spectator_fd < 0) {
+        perror("spectator port");
+        spectate_free(&spectators);
+        ansi_close(&spectator_screen);
+        return false;
+    }
+    return true;
 }
 
 /*
- * Functionality: Updates snake position based on current direction.
+ * Functionality: Renders this tick's frame for spectators, once for all of them: the cells
+ * the move changed for those in sync, then a keyframe if anyone is waiting for one.
  */
-void update_snake() {
-    // Save tail position
-    Point tail = snake.body[snake.length - 1];
-    
-    // Move body segments (each segment takes position of previous)
-    for (int i = snake.length - 1; i > 0; i--) {
-        snake.body[i] = snake.body[i - 1];
+void broadcast_frame(Point old_head, Point old_tail, int old_length, Point old_food) {
+    if (spectator_fd < 0) return;
+    if (spectate_idle(&spectators)) {
+        spectator_repaint = true; // The renderer's shadow no longer follows the game
+        return;
     }
-    
-    // Move head based on direction
-    switch (snake.dir) {
-        case UP:
-            snake.body[0].y--;
-            break;
-        case DOWN:
-            snake.body[0].y++;
-            break;
-        case LEFT:
-            snake.body[0].x--;
-            break;
-        case RIGHT:
-            snake.body[0].x++;
-            break;
+    ansi_begin_frame(&spectator_screen);
+    if (spectator_repaint) {
+        ansi_draw_full_frame(&spectator_screen, &game);
+        spectator_repaint = false;
+    } else {
+        ansi_draw_changes(&spectator_screen, &game, old_head, old_tail, old_length, old_food);
     }
-    
-    // Check if food is consumed
-    if (snake.body[0].x == food.x && snake.body[0].y == food.y) {
-        // Grow snake
-        snake.length++;
-        snake.body[snake.length - 1] = tail;
-        // Place new food
-        place_food();
+    spectate_publish(&spectators, &spectator_screen, false);
+    if (spectate_wants_keyframe(&spectators)) {
+        ansi_begin_frame(&spectator_screen);
+        ansi_redraw(&spectator_screen, &game);
+        spectate_publish(&spectators, &spectator_screen, true);
     }
 }
 
 /*
- * Functionality: Displays a simple start screen and waits for user to press space.
+ * Functionality: Starts the next game in place: resets the game with the next seed and
+ * starts the replay log over, keeping the game's memory, the pathfinder, the window and
+ * the open log file, so a restart needs no new process or terminal setup. Returns false
+ * if the log could not be rewritten.
  */
-void show_start_screen() {
-    clear();
-    int center_y = max_y / 2;
-    int center_x = max_x / 2;
-    
-    if (has_colors()) {
-        attron(COLOR_PAIR(COLOR_TEXT) | A_BOLD);
+bool restart_game() {
+    game_reset(&game, seed + (uint64_t)++games_played);
+    if (target_length > 0) game_set_target_length(&game, target_length);
+    pathfinder_reset(&pathfinder);
+    InputEvent ev;
+    while (input_pop(&input_queue, &ev)) {
+        // Turns meant for the last game
     }
-    
-    mvprintw(center_y - 3, center_x - 10, "================");
-    mvprintw(center_y - 2, center_x - 10, "   SNAKE GAME   ");
-    mvprintw(center_y - 1, center_x - 10, "================");
-    mvprintw(center_y + 1, center_x - 15, "Use Arrow Keys to Move");
-    mvprintw(center_y + 2, center_x - 12, "Eat food to grow");
-    mvprintw(center_y + 3, center_x - 15, "To Win: Reach a length of %d", snake.max_length);
-    mvprintw(center_y + 5, center_x - 10, "Press SPACE to start");
-    mvprintw(center_y + 6, center_x - 8, "Press 'q' to quit");
-    
-    if (has_colors()) {
-        attroff(COLOR_PAIR(COLOR_TEXT) | A_BOLD);
-    }
-    
-    refresh();
-    
-    timeout(-1); // Blocking input
-    int ch;
-    while ((ch = getch()) != ' ' && ch != 'q' && ch != 'Q');
-    timeout(0); // Back to non-blocking
+    input_time = 0;
+    spectator_repaint = true; // Their screens still show the last game
+    return replay_restart(&recorder, &game);
 }
 
 /*
- * Functionality: The main game loop handling input and updates.
+ * Functionality: The main game loop handling input and updates. The simulation runs on a
+ * fixed timestep from the monotonic clock; between ticks the process sleeps in poll()
+ * until either a key arrives or the next tick is due. Returns true if the player asked
+ * for another game, either mid-game or from the end screen.
  */
-void game_loop() {
+bool game_loop() {
     int ch;
     bool running = true;
-    int frame_count = 0;
-    int move_interval = 2; // Move snake every N frames (faster movement)
+    InputEvent ev;
+
+    // Border, HUD label and the initial snake are drawn once up front
+    TRACE_BEGIN(draw_full_frame);
+    draw_full_frame(&game);
+    TRACE_END(draw_full_frame);
+
+    long long next_tick = now_ns() + TICK_NS;
+    long long last_metrics = 0;
+    last_queued = game.snake.dir;
+
+    while (running && !game.game_over && !game.victory) {
+        wait_for_input(next_tick);
+
+        // Handle every key that arrived while we slept
+        while ((ch = getch()) != ERR) {
+            switch (ch) {
+                case 'q':
+                case 'Q':
+                    running = false;
+                    break;
+                case 'r':
+                case 'R':
+                    return true;
+                case KEY_UP:
+                    handle_turn(UP);
+                    break;
+                case KEY_DOWN:
+                    handle_turn(DOWN);
+                    break;
+                case KEY_LEFT:
+                    handle_turn(LEFT);
+                    break;
+                case KEY_RIGHT:
+                    handle_turn(RIGHT);
+                    break;
+                case 'a':
+                case 'A':
+                    // Hand control to the bot or back; keys queued meanwhile are dropped
+                    autopilot = !autopilot;
+                    while (input_pop(&input_queue, &ev)) {
+                        // discard
+                    }
+                    last_queued = game.snake.dir;
+                    break;
+                case 'm':
+                case 'M':
+                    show_metrics = !show_metrics;
+                    if (!show_metrics) draw_status("");
+                    last_metrics = 0;
+                    break;
+                case KEY_RESIZE:
+                    // Rebuild the viewport for the new size; a too-small terminal ends the game
+                    if (!layout_viewport()) {
+                        running = false;
+                        break;
+                    }
+                    TRACE_BEGIN(draw_full_frame);
+                    draw_full_frame(&game);
+                    TRACE_END(draw_full_frame);
+                    break;
+            }
+        }
+        if (!running) break;
+
+        // Run every simulation tick that has come due
+        long long now = now_ns();
+        long long draw_ns = 0;
+        int ticks_run = 0;
+        if (now >= next_tick) metric_add(&wake_lag, now - next_tick);
+        while (now >= next_tick && !game.game_over && !game.victory) {
+            Point old_head = *snake_segment(&game, 0);
+            Point old_tail = *snake_segment(&game, game.snake.length - 1);
+            int old_length = game.snake.length;
+            Point old_food = game.food;
+            long mark = alloc_mark(); // Covers the simulation, not ncurses drawing
+
+            next_tick += TICK_NS;
+
+            // Take one queued turn per tick, or let the autopilot steer
+            if (autopilot) {
+                game_turn(&game, path_direction(&pathfinder, &game));
+                last_queued = game.snake.dir;
+            } else if (input_pop(&input_queue, &ev)) {
+                game_turn(&game, ev.dir);
+                if (input_time == 0) input_time = ev.time_ns;
+            }
+            replay_record(&recorder, &game);
+            long long t0 = now_ns();
+            bool alive = game_step(&game, game.snake.dir);
+            long long t1 = now_ns();
+            metric_add(&sim_time, t1 - t0);
+            broadcast_frame(old_head, old_tail, old_length, old_food);
+            alloc_check(mark, "snake_game");
+            if (!alive) {
+                break; // Collision or win
+            }
 
-    while (running && !game_over && !victory) {
-        ch = getch();
+            // Only emit the cells this move touched
+            TRACE_BEGIN(draw_changes);
+            draw_changes(&game, old_head, old_tail, old_length, old_food);
+            TRACE_END(draw_changes);
+            draw_ns += now_ns() - t1;
 
-        // Handle input
-        switch (ch) {
-            case 'q':
-            case 'Q':
-                running = false;
-                break;
-            case KEY_UP:
-                if (snake.dir != DOWN) snake.dir = UP;
-                break;
-            case KEY_DOWN:
-                if (snake.dir != UP) snake.dir = DOWN;
-                break;
-            case KEY_LEFT:
-                if (snake.dir != RIGHT) snake.dir = LEFT;
-                break;
-            case KEY_RIGHT:
-                if (snake.dir != LEFT) snake.dir = RIGHT;
+            // After a long stall (e.g. a suspended terminal) resync instead of fast-forwarding
+            if (++ticks_run >= MAX_CATCHUP_TICKS) {
+                next_tick = now + TICK_NS;
                 break;
+            }
         }
 
-        // Update game state (move snake every N frames)
-        frame_count++;
-        if (frame_count >= move_interval) {
-            update_snake();
-            frame_count = 0;
-            
-            // Check collisions
-            if (check_collision()) {
-                game_over = true;
-                break;
-            }
-            
-            // Check win condition
-            if (check_win()) {
-                victory = true;
-                break;
-            }
+        // Spectators are served once per wakeup, after the ticks it ran
+        if (spectator_fd >= 0) {
+            spectate_accept(&spectators, spectator_fd);
+            spectate_flush(&spectators);
         }
-        
-        // Draw everything
-        // Clear both stdscr and game window
-        clear();
-        if (game_win) werase(game_win);
-
-        draw_border();
-        draw_snake();
-
-        // Draw food with larger character and color inside window
-        if (game_win) {
-            if (has_colors()) {
-                wattron(game_win, COLOR_PAIR(COLOR_FOOD) | A_BOLD);
+
+        // Render separately from simulation: one terminal update per frame
+        if (ticks_run > 0 && !game.game_over && !game.victory) {
+            long long t0 = now_ns();
+            if (show_metrics && t0 - last_metrics >= METRICS_HUD_NS) {
+                TRACE_BEGIN(draw_metrics);
+                draw_metrics();
+                wnoutrefresh(stdscr);
+                TRACE_END(draw_metrics);
+                last_metrics = t0;
             }
-            mvwaddch(game_win, food.y, food.x, ACS_DIAMOND);
-            if (has_colors()) {
-                wattroff(game_win, COLOR_PAIR(COLOR_FOOD) | A_BOLD);
+            // The terminal write: the frame is staged with wnoutrefresh()/pnoutrefresh()
+            // as it is drawn and sent here in one go, instead of a wrefresh() per window
+            TRACE_BEGIN(doupdate);
+            doupdate();
+            TRACE_END(doupdate);
+            long long t1 = now_ns();
+            metric_add(&render_time, draw_ns + (t1 - t0));
+            if (input_time) {
+                metric_add(&input_latency, t1 - input_time);
+                input_time = 0;
             }
         }
-
-        // Display score/length with color on stdscr (above the window)
-        if (has_colors()) {
-            attron(COLOR_PAIR(COLOR_TEXT));
-        }
-        mvprintw(win_start_y - 1, win_start_x, "Length: %d/%d", snake.length, snake.max_length);
-        if (has_colors()) {
-            attroff(COLOR_PAIR(COLOR_TEXT));
-        }
-
-        // Refresh windows
-        if (game_win) wrefresh(game_win);
-        usleep(DELAY); // Control game speed
     }
     
     // Display game over or victory message
     clear();
-    if (game_win) werase(game_win);
-    draw_border();
-    draw_snake();
     
     if (has_colors()) {
         attron(COLOR_PAIR(COLOR_TEXT) | A_BOLD);
     }
     
-    if (game_over) {
+    if (game.game_over) {
         mvprintw(max_y / 2 - 1, max_x / 2 - 5, "GAME OVER!");
-        mvprintw(max_y / 2, max_x / 2 - 8, "Final Length: %d", snake.length);
-    } else if (victory) {
+        mvprintw(max_y / 2, max_x / 2 - 8, "Final Length: %d", game.snake.length);
+    } else if (game.victory) {
         mvprintw(max_y / 2 - 1, max_x / 2 - 5, "YOU WIN!");
-        mvprintw(max_y / 2, max_x / 2 - 8, "Length: %d/%d", snake.length, snake.max_length);
+        mvprintw(max_y / 2, max_x / 2 - 8, "Length: %d/%d", game.snake.length, game.snake.max_length);
     }
     
-    mvprintw(max_y / 2 + 1, max_x / 2 - 8, "Press 'q' to quit");
+    mvprintw(max_y / 2 + 1, max_x / 2 - 8, "Press 'r' to play again");
+    mvprintw(max_y / 2 + 2, max_x / 2 - 8, "Press 'q' to quit");
     
     if (has_colors()) {
         attroff(COLOR_PAIR(COLOR_TEXT) | A_BOLD);
     }
-    if (game_win) wrefresh(game_win);
     refresh();
     
-    // Wait for quit key if game ended
+    // Wait for quit or restart key if game ended
     timeout(-1); // Blocking input
-    while ((ch = getch()) != 'q' && ch != 'Q');
+    while ((ch = getch()) != 'q' && ch != 'Q' && ch != 'r' && ch != 'R');
+    timeout(0); // Back to non-blocking for the next game
+    return ch == 'r' || ch == 'R';
 }
 
-int main() {
-    // Initialize random seed once
-    srand(time(NULL));
-    
+/*
+ * Functionality: Prints command line usage to stderr.
+ */
+void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [-s HxW] [-l length] [-S seed] [-r file] [-m file] [-w port] [-a]\n", prog);
+    fprintf(stderr, "  -s HxW     pit size (default 20x40, up to %dx%d)\n", MAX_PIT_SIDE, MAX_PIT_SIDE);
+    fprintf(stderr, "  -l length  length that wins (default half the perimeter)\n");
+    fprintf(stderr, "  -S seed    RNG seed of the first game; restart n uses seed + n (default: current time)\n");
+    fprintf(stderr, "  -r file    record a replay log of the latest game (play it back with snake_headless -p)\n");
+    fprintf(stderr, "  -a         start with the autopilot steering ('a' toggles it)\n");
+    fprintf(stderr, "  -m file    write frame timing stats to file on exit ('m' shows them in game)\n");
+    fprintf(stderr, "  -w port    let spectators watch over TCP (e.g. nc host port)\n");
+}
+
+int main(int argc, char **argv) {
+    seed = (uint64_t)time(NULL);
+    const char *replay_path = NULL;
+    const char *stats_path = NULL;
+    int spectator_port = 0;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "s:l:S:r:m:w:a")) != -1) {
+        switch (opt) {
+            case 's':
+                if (!parse_pit_size(optarg, &pit_height, &pit_width)) {
+                    usage(argv[0]);
+                    return 1;
+                }
+                break;
+            case 'l':
+                target_length = atoi(optarg);
+                break;
+            case 'S':
+                seed = strtoull(optarg, NULL, 10);
+                break;
+            case 'r':
+                replay_path = optarg;
+                break;
+            case 'm':
+                stats_path = optarg;
+                break;
+            case 'w':
+                spectator_port = atoi(optarg);
+                break;
+            case 'a':
+                autopilot = true;
+                break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+
+    // Initialize snake and the first food, seeding the game's RNG once
+    if (!game_init(&game, pit_height, pit_width, seed)) {
+        printf("Out of memory\n");
+        return 1;
+    }
+    if (target_length > 0) game_set_target_length(&game, target_length);
+    if (!pathfinder_init(&pathfinder, pit_height, pit_width)) {
+        printf("Out of memory\n");
+        game_free(&game);
+        return 1;
+    }
+    if (replay_path && !replay_open(&recorder, replay_path, &game)) {
+        perror(replay_path);
+        game_free(&game);
+        pathfinder_free(&pathfinder);
+        return 1;
+    }
+    if (spectator_port > 0 && !open_spectators(spectator_port)) {
+        replay_close(&recorder, &game);
+        game_free(&game);
+        pathfinder_free(&pathfinder);
+        return 1;
+    }
+
     init_game();
     
-    // Check if terminal is large enough and create centered small game window
-    getmaxyx(stdscr, max_y, max_x);
-    // Require a bit of padding around window for messages
-    if (max_y < pit_height + 4 || max_x < pit_width + 4) {
+    // Check if terminal is large enough and create the centered viewport
+    if (!layout_viewport()) {
         endwin();
-        printf("Terminal too small! Need at least %dx%d (including borders)\n", pit_height + 2, pit_width + 2);
+        replay_close(&recorder, &game);
+        game_free(&game);
+        pathfinder_free(&pathfinder);
+        render_close();
+        printf("Terminal too small! Need at least %dx%d\n", MIN_ROWS, MIN_COLS);
         return 1;
     }
-
-    // Center the game window
-    win_start_y = (max_y - (pit_height + 2)) / 2;
-    win_start_x = (max_x - (pit_width + 2)) / 2;
-    game_win = newwin(pit_height + 2, pit_width + 2, win_start_y, win_start_x);
-    keypad(game_win, TRUE);
-
-    // Initialize snake
-    init_snake();
     
     // Show start screen
     show_start_screen();
     
-    // Place initial food
-    place_food();
-    
-    // Start game loop
-    game_loop();
-    
+    // Play until the player quits; each restart reuses everything set up above
+    bool saved = true;
+    while (game_loop() && (saved = restart_game())) {
+    }
+
+    // Finish the log before the game is freed; it needs the final tick count
+    saved = replay_close(&recorder, &game) && saved;
     cleanup_game();
+    if (!saved) {
+        fprintf(stderr, "Failed to write replay %s\n", replay_path);
+        return 1;
+    }
+    if (stats_path && !write_stats(stats_path)) {
+        perror(stats_path);
+        return 1;
+    }
     return 0;
 }
 
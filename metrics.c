@@ -0,0 +1,65 @@
+#include <stdlib.h>
+
+#include "metrics.h"
+
+/*
+ * Functionality: Records one sample of ns nanoseconds.
+ */
+void metric_add(Metric *m, long long ns) {
+    m->samples[m->next] = ns;
+    m->next = (m->next + 1) % METRIC_WINDOW;
+    if (m->filled < METRIC_WINDOW) m->filled++;
+    m->count++;
+    m->sum += ns;
+    if (ns > m->max) m->max = ns;
+}
+
+/*
+ * Functionality: qsort comparator for long long samples.
+ */
+static int compare_samples(const void *a, const void *b) {
+    long long x = *(const long long *)a, y = *(const long long *)b;
+    return (x > y) - (x < y);
+}
+
+/*
+ * Functionality: Returns the pct-th percentile (nearest rank) of the rolling window, or 0
+ * with no samples yet. Sorts a copy of at most METRIC_WINDOW samples.
+ */
+long long metric_percentile(const Metric *m, int pct) {
+    if (m->filled == 0) return 0;
+    long long sorted[METRIC_WINDOW];
+    for (int i = 0; i < m->filled; i++) {
+        sorted[i] = m->samples[i];
+    }
+    qsort(sorted, m->filled, sizeof(sorted[0]), compare_samples);
+
+    int rank = (pct * m->filled + 99) / 100; // 1-based
+    if (rank < 1) rank = 1;
+    return sorted[rank - 1];
+}
+
+/*
+ * Functionality: Formats ns as a short human-readable duration ("850ns", "12us", "3.4ms").
+ */
+void format_duration(char *buf, size_t size, long long ns) {
+    if (ns < 1000) {
+        snprintf(buf, size, "%lldns", ns);
+    } else if (ns < 1000000) {
+        snprintf(buf, size, "%lldus", ns / 1000);
+    } else if (ns < 100000000) {
+        snprintf(buf, size, "%.1fms", ns / 1e6);
+    } else {
+        snprintf(buf, size, "%lldms", ns / 1000000);
+    }
+}
+
+/*
+ * Functionality: Writes one line of whole-run and rolling-window statistics for m to f,
+ * all in microseconds.
+ */
+void metric_write(FILE *f, const char *name, const Metric *m) {
+    fprintf(f, "%s count=%lld mean_us=%.2f p50_us=%.2f p99_us=%.2f max_us=%.2f\n", name, m->count,
+            m->count ? m->sum / 1e3 / m->count : 0.0, metric_percentile(m, 50) / 1e3,
+            metric_percentile(m, 99) / 1e3, m->max / 1e3);
+}
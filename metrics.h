@@ -0,0 +1,27 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdio.h>
+
+/*
+ * Timing counters for the frontend. Each Metric keeps the last METRIC_WINDOW
+ * samples (nanoseconds) for rolling percentiles, plus whole-run totals.
+ */
+
+#define METRIC_WINDOW 256 // Samples behind each rolling percentile
+
+typedef struct {
+    long long samples[METRIC_WINDOW]; // Ring of the most recent samples
+    int next;         // Slot the next sample goes to
+    int filled;       // Valid samples in the ring
+    long long count;  // Samples since the start of the run
+    long long sum;
+    long long max;
+} Metric;
+
+void metric_add(Metric *m, long long ns);
+long long metric_percentile(const Metric *m, int pct);
+void format_duration(char *buf, size_t size, long long ns);
+void metric_write(FILE *f, const char *name, const Metric *m);
+
+#endif
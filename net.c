@@ -0,0 +1,157 @@
+#include <errno.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+
+#include "net.h"
+#include "bytes.h"
+
+/*
+ * Functionality: Returns the largest WELCOME message a room of r's size and capacity can
+ * produce: every pit cell covered by snakes and all food on the board.
+ */
+size_t net_welcome_bound(const Room *r) {
+    size_t cells = (size_t)r->pit_height * r->pit_width;
+    return NET_HEADER_SIZE + 18 + 6 * (size_t)r->max_snakes + 4 * cells + 4 * (size_t)r->food_capacity;
+}
+
+/*
+ * Functionality: Returns the largest TICK packet r can produce.
+ */
+size_t net_tick_bound(const Room *r) {
+    return NET_HEADER_SIZE + 12 + (size_t)r->event_capacity * NET_EVENT_SIZE;
+}
+
+/*
+ * Functionality: Encodes the room's queued events as one TICK packet into out, which must
+ * hold net_tick_bound() bytes. Returns its size.
+ */
+size_t net_encode_tick(const Room *r, uint8_t *out) {
+    size_t size = NET_HEADER_SIZE + 12 + (size_t)r->event_count * NET_EVENT_SIZE;
+    out[0] = NET_MSG_TICK;
+    put_le(out + 1, size - NET_HEADER_SIZE, 4);
+    put_le(out + 5, (uint64_t)r->ticks, 8);
+    put_le(out + 13, (uint64_t)r->event_count, 4);
+    uint8_t *p = out + 17;
+    for (int i = 0; i < r->event_count; i++) {
+        const RoomEvent *e = &r->events[i];
+        p[0] = (uint8_t)e->kind;
+        put_le(p + 1, (uint64_t)e->snake, 2);
+        put_le(p + 3, (uint64_t)e->at.x, 2);
+        put_le(p + 5, (uint64_t)e->at.y, 2);
+        p += NET_EVENT_SIZE;
+    }
+    return size;
+}
+
+/*
+ * Functionality: Appends size bytes to a client's output. Returns false, marking the client
+ * closing, if they do not fit: it has fallen too far behind.
+ */
+bool net_queue(Client *c, const uint8_t *data, size_t size) {
+    if (c->closing || size > c->out_cap - c->out_len) {
+        c->closing = true;
+        return false;
+    }
+    memcpy(c->out + c->out_len, data, size);
+    c->out_len += size;
+    return true;
+}
+
+/*
+ * Functionality: Appends a WELCOME snapshot of room r to a new client's output. Returns
+ * false, marking the client closing, if it does not fit.
+ */
+bool net_queue_welcome(Client *c, const Room *r) {
+    size_t size = NET_HEADER_SIZE + 18;
+    for (int i = 0; i < r->max_snakes; i++) {
+        if (r->snakes[i].alive) size += 6 + 4 * (size_t)r->snakes[i].snake.length;
+    }
+    size += 4 * (size_t)r->food_count;
+    if (c->closing || size > c->out_cap - c->out_len) {
+        c->closing = true;
+        return false;
+    }
+
+    uint8_t *p = c->out + c->out_len;
+    p[0] = NET_MSG_WELCOME;
+    put_le(p + 1, size - NET_HEADER_SIZE, 4);
+    put_le(p + 5, (uint64_t)r->pit_height, 2);
+    put_le(p + 7, (uint64_t)r->pit_width, 2);
+    put_le(p + 9, (uint64_t)c->id, 2);
+    put_le(p + 11, (uint64_t)r->ticks, 8);
+    put_le(p + 19, (uint64_t)r->alive_count, 2);
+    p += 21;
+    for (int i = 0; i < r->max_snakes; i++) {
+        const RoomSnake *snake = &r->snakes[i];
+        if (!snake->alive) continue;
+        put_le(p, (uint64_t)i, 2);
+        put_le(p + 2, (uint64_t)snake->snake.length, 4);
+        p += 6;
+        for (int k = 0; k < snake->snake.length; k++) {
+            const Point *seg = room_segment(snake, k);
+            put_le(p, (uint64_t)seg->x, 2);
+            put_le(p + 2, (uint64_t)seg->y, 2);
+            p += 4;
+        }
+    }
+    put_le(p, (uint64_t)r->food_count, 2);
+    p += 2;
+    for (int i = 0; i < r->food_count; i++) {
+        put_le(p, (uint64_t)r->food[i].x, 2);
+        put_le(p + 2, (uint64_t)r->food[i].y, 2);
+        p += 4;
+    }
+    c->out_len += size;
+    c->welcomed = true;
+    return true;
+}
+
+/*
+ * Functionality: Sends as much pending output as the socket takes, in at most one send()
+ * call, and keeps the client registered for EPOLLOUT (with the client as its epoll data)
+ * while some is left. Returns false, marking the client closing, on a socket error.
+ */
+bool net_flush(Client *c, int epoll_fd) {
+    if (c->closing) return false;
+    if (c->out_len > 0) {
+        ssize_t n = send(c->fd, c->out, c->out_len, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            c->closing = true;
+            return false;
+        }
+        if (n > 0) {
+            memmove(c->out, c->out + n, c->out_len - (size_t)n);
+            c->out_len -= (size_t)n;
+        }
+    }
+
+    bool want_write = c->out_len > 0;
+    if (want_write != c->want_write) {
+        struct epoll_event ev = { .events = EPOLLIN | (want_write ? EPOLLOUT : 0), .data.ptr = c };
+        epoll_ctl(epoll_fd, EPOLL_CTL_MOD, c->fd, &ev);
+        c->want_write = want_write;
+    }
+    return true;
+}
+
+/*
+ * Functionality: Maps a client key byte to a direction. Returns false for other bytes.
+ */
+bool net_key_direction(uint8_t key, Direction *dir) {
+    switch (key) {
+        case 'w':
+            *dir = UP;
+            return true;
+        case 's':
+            *dir = DOWN;
+            return true;
+        case 'a':
+            *dir = LEFT;
+            return true;
+        case 'd':
+            *dir = RIGHT;
+            return true;
+    }
+    return false;
+}
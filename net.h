@@ -0,0 +1,52 @@
+#ifndef NET_H
+#define NET_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "game.h"
+#include "room.h"
+
+/*
+ * snake_server wire format and per-connection output buffering.
+ *
+ * Clients send one byte per turn: 'w', 'a', 's' or 'd'; anything else is
+ * ignored. The server sends messages framed as type u8, payload size u32,
+ * payload (integers little-endian):
+ *   WELCOME (1), once, on the first tick after joining a room:
+ *     pit_height u16, pit_width u16, your snake id u16, tick u64,
+ *     snake_count u16, then per snake id u16, length u32 and length x/y u16
+ *     pairs head first, then food_count u16 and food x/y u16 pairs
+ *   TICK (2), every tick after that: tick u64, event_count u32, then per event
+ *     kind u8 (a RoomEventKind), snake id u16, x u16, y u16
+ * So after the one snapshot each tick costs NET_EVENT_SIZE bytes per change,
+ * never a board dump.
+ */
+
+#define NET_MSG_WELCOME 1
+#define NET_MSG_TICK 2
+#define NET_HEADER_SIZE 5  // type u8, payload size u32
+#define NET_EVENT_SIZE 7
+
+typedef struct {
+    int fd;              // -1 when the slot is free
+    int id;              // Snake id in the client's room
+    bool welcomed;       // Has had its snapshot, so gets tick packets
+    bool want_write;     // Registered for EPOLLOUT while output is pending
+    bool closing;        // Failed or fell too far behind; waiting to be dropped
+    uint8_t *out;        // Unsent output, a fixed buffer of out_cap bytes
+    size_t out_len;
+    size_t out_cap;
+    void *owner;         // Whatever the server keeps the client in
+} Client;
+
+size_t net_welcome_bound(const Room *r);
+size_t net_tick_bound(const Room *r);
+size_t net_encode_tick(const Room *r, uint8_t *out);
+bool net_queue(Client *c, const uint8_t *data, size_t size);
+bool net_queue_welcome(Client *c, const Room *r);
+bool net_flush(Client *c, int epoll_fd);
+bool net_key_direction(uint8_t key, Direction *dir);
+
+#endif
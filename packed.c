@@ -0,0 +1,114 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "packed.h"
+
+/*
+ * Functionality: Returns move i of a linear move array.
+ */
+static inline Direction get_move(const uint8_t *moves, int i) {
+    return (Direction)((moves[i >> 2] >> ((i & 3) * 2)) & 3);
+}
+
+/*
+ * Functionality: Stores move i of a linear move array.
+ */
+static inline void set_move(uint8_t *moves, int i, Direction dir) {
+    int shift = (i & 3) * 2;
+    moves[i >> 2] = (uint8_t)((moves[i >> 2] & ~(3 << shift)) | ((int)dir << shift));
+}
+
+/*
+ * Functionality: Returns the direction of the one-cell step from a to b.
+ */
+static Direction step_between(Point a, Point b) {
+    if (b.x > a.x) return RIGHT;
+    if (b.x < a.x) return LEFT;
+    if (b.y > a.y) return DOWN;
+    return UP;
+}
+
+/*
+ * Functionality: Returns the segment behind p, given move, the step that led from that
+ * segment to p.
+ */
+Point packed_behind(Point p, Direction move) {
+    switch (move) {
+        case UP:    p.y++; break;
+        case DOWN:  p.y--; break;
+        case LEFT:  p.x++; break;
+        case RIGHT: p.x--; break;
+    }
+    return p;
+}
+
+/*
+ * Functionality: Replaces p's moves with an empty buffer of at least capacity moves. Returns
+ * false if out of memory.
+ */
+static bool reserve_moves(PackedBody *p, int capacity) {
+    capacity = (capacity + 3) & ~3;
+    uint8_t *moves = (uint8_t *)calloc((size_t)capacity / 4, 1);
+    if (!moves) return false;
+    free(p->moves);
+    p->moves = moves;
+    p->capacity = capacity;
+    return true;
+}
+
+/*
+ * Functionality: Creates an empty packed body with room for capacity moves before it grows.
+ * Returns false if out of memory.
+ */
+bool packed_init(PackedBody *p, int capacity) {
+    memset(p, 0, sizeof(*p));
+    return reserve_moves(p, capacity > 4 ? capacity : 4);
+}
+
+/*
+ * Functionality: Releases a packed body.
+ */
+void packed_free(PackedBody *p) {
+    free(p->moves);
+    memset(p, 0, sizeof(*p));
+}
+
+/*
+ * Functionality: Packs the body of game g into p, growing p's buffer if needed. Returns false
+ * if out of memory.
+ */
+bool packed_from_game(PackedBody *p, const GameState *g) {
+    int length = g->snake.length;
+    p->length = 0;
+    if (length - 1 > p->capacity && !reserve_moves(p, length - 1)) return false;
+
+    p->length = length;
+    p->head = *snake_segment(g, 0);
+    p->tail = *snake_segment(g, length - 1);
+    for (int i = 0; i < length - 1; i++) {
+        set_move(p->moves, i, step_between(*snake_segment(g, i + 1), *snake_segment(g, i)));
+    }
+    return true;
+}
+
+/*
+ * Functionality: Writes p's moves linearly, head end first, into out (packed_size(length)
+ * bytes).
+ */
+void packed_write(const PackedBody *p, uint8_t *out) {
+    memset(out, 0, packed_size(p->length));
+    for (int i = 0; i < p->length - 1; i++) {
+        set_move(out, i, get_move(p->moves, i));
+    }
+}
+
+/*
+ * Functionality: Decodes a body written by packed_write() back into length Points, head first.
+ */
+void packed_unpack(Point head, int length, const uint8_t *moves, Point *out) {
+    if (length < 1) return;
+    out[0] = head;
+    for (int i = 0; i < length - 1; i++) {
+        out[i + 1] = packed_behind(out[i], get_move(moves, i));
+    }
+}
@@ -0,0 +1,43 @@
+#ifndef PACKED_H
+#define PACKED_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "game.h"
+
+/*
+ * Bit-packed snake bodies. Neighboring segments are always one step apart,
+ * so a body is fully described by its head, its length and the direction of
+ * each step: 2 bits per segment instead of an 8-byte Point, about 32x
+ * smaller. Move i is the direction from segment i + 1 to segment i, so
+ * walking from the head decodes the body one segment at a time.
+ *
+ * PackedBody holds a game's body packed that way, head end first, plus its
+ * tail, for archive snapshots (see archive.h). packed_write() emits the
+ * moves four per byte (low bits first), and packed_unpack() decodes them.
+ */
+
+typedef struct {
+    uint8_t *moves;   // 2-bit moves, four per byte, move 0 first
+    int capacity;     // Move slots in moves
+    int length;       // Segments, so length - 1 moves are stored
+    Point head;
+    Point tail;
+} PackedBody;
+
+/*
+ * Functionality: Returns the number of bytes packed_write() emits for a length-segment body.
+ */
+static inline size_t packed_size(int length) {
+    return length > 1 ? (size_t)(length - 1 + 3) / 4 : 0;
+}
+
+bool packed_init(PackedBody *p, int capacity);
+void packed_free(PackedBody *p);
+bool packed_from_game(PackedBody *p, const GameState *g);
+Point packed_behind(Point p, Direction move);
+void packed_write(const PackedBody *p, uint8_t *out);
+void packed_unpack(Point head, int length, const uint8_t *moves, Point *out);
+
+#endif
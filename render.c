@@ -0,0 +1,345 @@
+#include "render.h"
+
+// The pit is drawn into an off-screen pad holding a slab of the grid around the
+// camera; the visible viewport is copied from it with pnoutrefresh(). The slab is
+// only refilled when the camera leaves it, so per-frame work follows the terminal
+// size, never the pit size.
+WINDOW *game_pad = NULL;
+int win_start_y = 0;  // Screen position of the viewport
+int win_start_x = 0;
+int view_height = 0;  // Viewport size on screen
+int view_width = 0;
+int view_y = 0;       // Grid coords shown at the viewport's top-left cell
+int view_x = 0;
+int pad_y = 0;        // Grid coords held in the pad's top-left cell
+int pad_x = 0;
+
+/*
+ * Functionality: Sets up the color pairs used by the renderer.
+ */
+void init_colors() {
+    // Initialize colors if terminal supports it
+    if (has_colors()) {
+        start_color();
+        // Green snake head
+        init_pair(COLOR_SNAKE_HEAD, COLOR_GREEN, COLOR_BLACK);
+        // Bright green snake body
+        init_pair(COLOR_SNAKE_BODY, COLOR_GREEN, COLOR_BLACK);
+        // Red food
+        init_pair(COLOR_FOOD, COLOR_RED, COLOR_BLACK);
+        // Cyan border
+        init_pair(COLOR_BORDER, COLOR_CYAN, COLOR_BLACK);
+        // Yellow text
+        init_pair(COLOR_TEXT, COLOR_YELLOW, COLOR_BLACK);
+    }
+}
+
+/*
+ * Functionality: Creates the pad and viewport for game g at screen position (start_y,
+ * start_x), showing at most height x width cells. The pad adds half a viewport of
+ * margin on every side (up to the pit's own size). Returns false if ncurses fails.
+ */
+bool render_open(const GameState *g, int start_y, int start_x, int height, int width) {
+    render_close();
+    int grid_h = g->pit_height + 2, grid_w = g->pit_width + 2;
+    view_height = height < grid_h ? height : grid_h;
+    view_width = width < grid_w ? width : grid_w;
+    win_start_y = start_y;
+    win_start_x = start_x;
+
+    int pad_h = view_height * 2, pad_w = view_width * 2;
+    if (pad_h > grid_h) pad_h = grid_h;
+    if (pad_w > grid_w) pad_w = grid_w;
+    game_pad = newpad(pad_h, pad_w);
+    view_y = view_x = pad_y = pad_x = 0;
+    return game_pad != NULL;
+}
+
+/*
+ * Functionality: Releases the pad.
+ */
+void render_close() {
+    if (game_pad) {
+        delwin(game_pad);
+        game_pad = NULL;
+    }
+}
+
+/*
+ * Functionality: Queues the viewport's part of the pad for the next doupdate().
+ */
+void render_present() {
+    if (!game_pad) return;
+    pnoutrefresh(game_pad, view_y - pad_y, view_x - pad_x, win_start_y, win_start_x,
+                 win_start_y + view_height - 1, win_start_x + view_width - 1);
+}
+
+/*
+ * Functionality: Maps grid coords (x, y) into the pad. Returns false if the cell is outside
+ * the slab the pad currently holds.
+ */
+static bool to_pad(int x, int y, int *py, int *px) {
+    int rows, cols;
+    getmaxyx(game_pad, rows, cols);
+    *py = y - pad_y;
+    *px = x - pad_x;
+    return *py >= 0 && *py < rows && *px >= 0 && *px < cols;
+}
+
+/*
+ * Functionality: Draws ch with attributes attr at grid coords (x, y) if the pad holds it.
+ */
+static void put_cell(int x, int y, chtype ch, attr_t attr) {
+    int py, px;
+    if (!to_pad(x, y, &py, &px)) return;
+    if (has_colors() && attr) {
+        wattron(game_pad, attr);
+    }
+    mvwaddch(game_pad, py, px, ch);
+    if (has_colors() && attr) {
+        wattroff(game_pad, attr);
+    }
+}
+
+/*
+ * Functionality: Returns the line-drawing glyph for border cell (x, y).
+ */
+static chtype border_glyph(const GameState *g, int x, int y) {
+    bool top = (y == 0), bottom = (y == g->pit_height + 1);
+    bool left = (x == 0), right = (x == g->pit_width + 1);
+    if (top && left) return ACS_ULCORNER;
+    if (top && right) return ACS_URCORNER;
+    if (bottom && left) return ACS_LLCORNER;
+    if (bottom && right) return ACS_LRCORNER;
+    if (top || bottom) return ACS_HLINE;
+    return ACS_VLINE;
+}
+
+/*
+ * Functionality: Draws the border around the snake pit with color. Only the part of the
+ * border inside the pad's slab is drawn, so the cost follows the terminal, not the pit.
+ */
+void draw_border(const GameState *g) {
+    if (!game_pad) return;
+    int rows, cols;
+    getmaxyx(game_pad, rows, cols);
+    int x0 = pad_x, x1 = pad_x + cols - 1;
+    int y0 = pad_y, y1 = pad_y + rows - 1;
+    int bottom = g->pit_height + 1, right = g->pit_width + 1;
+    attr_t attr = COLOR_PAIR(COLOR_BORDER);
+
+    for (int x = x0; x <= x1; x++) {
+        if (y0 == 0) put_cell(x, 0, border_glyph(g, x, 0), attr);
+        if (y1 == bottom) put_cell(x, bottom, border_glyph(g, x, bottom), attr);
+    }
+    for (int y = y0; y <= y1; y++) {
+        if (x0 == 0) put_cell(0, y, border_glyph(g, 0, y), attr);
+        if (x1 == right) put_cell(right, y, border_glyph(g, right, y), attr);
+    }
+}
+
+/*
+ * Functionality: Returns the head glyph for the snake's current direction.
+ */
+chtype head_glyph(const GameState *g) {
+    switch (g->snake.dir) {
+        case UP:
+            return '^';
+        case DOWN:
+            return 'v';
+        case LEFT:
+            return '<';
+        case RIGHT:
+        default:
+            return '>';
+    }
+}
+
+/*
+ * Functionality: Draws a single snake segment at p, as the head glyph or a body block.
+ */
+void draw_segment(const GameState *g, Point p, bool is_head) {
+    if (is_head) {
+        put_cell(p.x, p.y, head_glyph(g), COLOR_PAIR(COLOR_SNAKE_HEAD) | A_BOLD);
+    } else {
+        put_cell(p.x, p.y, ACS_BLOCK, COLOR_PAIR(COLOR_SNAKE_BODY));
+    }
+}
+
+/*
+ * Functionality: Draws the food with larger character and color inside the window.
+ */
+void draw_food(const GameState *g) {
+    if (!game_pad || g->food.x <= 0) return;
+    put_cell(g->food.x, g->food.y, ACS_DIAMOND, COLOR_PAIR(COLOR_FOOD) | A_BOLD);
+}
+
+/*
+ * Functionality: Refills the pad's whole slab: the border, body cells read off the
+ * occupancy grid, the head and the food. Costs O(pad), whatever the pit size or snake
+ * length.
+ */
+void draw_visible(const GameState *g) {
+    if (!game_pad) return;
+    werase(game_pad);
+
+    int rows, cols;
+    getmaxyx(game_pad, rows, cols);
+    for (int py = 0; py < rows; py++) {
+        int y = py + pad_y;
+        if (y < 1 || y > g->pit_height) continue;
+        for (int px = 0; px < cols; px++) {
+            int x = px + pad_x;
+            if (x >= 1 && x <= g->pit_width && g->occupancy[grid_cell(g, x, y)]) {
+                put_cell(x, y, ACS_BLOCK, COLOR_PAIR(COLOR_SNAKE_BODY));
+            }
+        }
+    }
+    draw_segment(g, *snake_segment(g, 0), true);
+    draw_food(g);
+    draw_border(g);
+}
+
+/*
+ * Functionality: Clamps a camera or slab origin so [origin, origin + size) stays on the grid.
+ */
+static int clamp_origin(int origin, int size, int grid_size) {
+    if (origin > grid_size - size) origin = grid_size - size;
+    if (origin < 0) origin = 0;
+    return origin;
+}
+
+/*
+ * Functionality: Keeps the head inside the middle half of the viewport, scrolling the
+ * camera just far enough when it strays (or centering it when force is set). Axes where
+ * the pit fits stay pinned at 0. Returns true if the camera moved.
+ */
+bool update_camera(const GameState *g, bool force) {
+    if (!game_pad) return false;
+    Point head = *snake_segment(g, 0);
+    int new_y = view_y, new_x = view_x;
+    int margin_y = view_height / 4, margin_x = view_width / 4;
+
+    if (force) {
+        new_y = head.y - view_height / 2;
+        new_x = head.x - view_width / 2;
+    } else {
+        if (head.y < view_y + margin_y) new_y = head.y - margin_y;
+        if (head.y >= view_y + view_height - margin_y) new_y = head.y - view_height + margin_y + 1;
+        if (head.x < view_x + margin_x) new_x = head.x - margin_x;
+        if (head.x >= view_x + view_width - margin_x) new_x = head.x - view_width + margin_x + 1;
+    }
+    new_y = clamp_origin(new_y, view_height, g->pit_height + 2);
+    new_x = clamp_origin(new_x, view_width, g->pit_width + 2);
+
+    if (new_y == view_y && new_x == view_x) return false;
+    view_y = new_y;
+    view_x = new_x;
+    return true;
+}
+
+/*
+ * Functionality: Re-centers the pad's slab on the camera and refills it if the camera has
+ * left it (or when force is set). Returns true if the pad was refilled.
+ */
+static bool recenter_pad(const GameState *g, bool force) {
+    int rows, cols;
+    getmaxyx(game_pad, rows, cols);
+    if (!force && view_y >= pad_y && view_y + view_height <= pad_y + rows &&
+        view_x >= pad_x && view_x + view_width <= pad_x + cols) {
+        return false;
+    }
+    pad_y = clamp_origin(view_y - (rows - view_height) / 2, rows, g->pit_height + 2);
+    pad_x = clamp_origin(view_x - (cols - view_width) / 2, cols, g->pit_width + 2);
+    draw_visible(g);
+    return true;
+}
+
+/*
+ * Functionality: Draws the score/length HUD on stdscr (above the window). With
+ * label_only set, draws just the static "Length: " text; otherwise just the numbers.
+ */
+void draw_hud(const GameState *g, bool label_only) {
+    if (has_colors()) {
+        attron(COLOR_PAIR(COLOR_TEXT));
+    }
+    if (label_only) {
+        mvprintw(win_start_y - 1, win_start_x, "Length: ");
+    } else {
+        mvprintw(win_start_y - 1, win_start_x + 8, "%d/%d", g->snake.length, g->snake.max_length);
+    }
+    if (has_colors()) {
+        attroff(COLOR_PAIR(COLOR_TEXT));
+    }
+}
+
+/*
+ * Functionality: Draws a status line on the HUD row to the right of the length, clipped to
+ * the screen. An empty text clears it.
+ */
+void draw_status(const char *text) {
+    int col = win_start_x + HUD_STATUS_COL;
+    if (col >= COLS) return;
+    move(win_start_y - 1, col);
+    clrtoeol();
+    if (has_colors()) {
+        attron(COLOR_PAIR(COLOR_TEXT));
+    }
+    addnstr(text, COLS - col);
+    if (has_colors()) {
+        attroff(COLOR_PAIR(COLOR_TEXT));
+    }
+}
+
+/*
+ * Functionality: Redraws the whole playfield from scratch. Used when the game starts
+ * (or the terminal is resized); every later frame only touches the cells that changed.
+ */
+void draw_full_frame(const GameState *g) {
+    clear();
+    if (game_pad) {
+        update_camera(g, true);
+        recenter_pad(g, true);
+    }
+    draw_hud(g, true);
+    draw_hud(g, false);
+
+    // Batch stdscr and the viewport into a single terminal update
+    wnoutrefresh(stdscr);
+    render_present();
+    doupdate();
+}
+
+/*
+ * Functionality: Draws only what changed during the last move: the vacated tail, the
+ * old head (now a body block), the new head, the food if it moved and the length. The
+ * camera follows the head; the pad is only refilled when the camera leaves its slab.
+ */
+void draw_changes(const GameState *g, Point old_head, Point old_tail, int old_length, Point old_food) {
+    if (!game_pad) return;
+    Point new_head = *snake_segment(g, 0);
+
+    bool refilled = update_camera(g, false) && recenter_pad(g, false);
+    if (!refilled) {
+        // The tail left its cell unless the snake grew or the head moved into it
+        if (g->snake.length == old_length &&
+            !(old_tail.x == new_head.x && old_tail.y == new_head.y)) {
+            put_cell(old_tail.x, old_tail.y, ' ', 0);
+        }
+        if (g->snake.length > 1) {
+            draw_segment(g, old_head, false);
+        }
+        draw_segment(g, new_head, true);
+
+        if (g->food.x != old_food.x || g->food.y != old_food.y) {
+            draw_food(g);
+        }
+    }
+    if (g->snake.length != old_length) {
+        draw_hud(g, false);
+        wnoutrefresh(stdscr);
+    }
+
+    // Queued only; the caller flushes once per frame with doupdate()
+    render_present();
+}
@@ -0,0 +1,49 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+#include <ncurses.h>
+
+#include "game.h"
+
+/*
+ * ncurses renderer for a GameState. The pit is drawn into an off-screen pad
+ * holding a slab of the grid around a camera that follows the head; the
+ * viewport on screen is copied out of it. draw_full_frame() paints everything
+ * once; afterwards draw_changes() touches only the cells a move changed, and
+ * the slab is refilled from the occupancy grid only when the camera leaves it.
+ */
+
+// Color pairs
+#define COLOR_SNAKE_HEAD 1
+#define COLOR_SNAKE_BODY 2
+#define COLOR_FOOD 3
+#define COLOR_BORDER 4
+#define COLOR_TEXT 5
+
+#define HUD_STATUS_COL 20 // Column of the status line, relative to the viewport
+
+// Pad, viewport placement and camera
+extern WINDOW *game_pad;
+extern int win_start_y;
+extern int win_start_x;
+extern int view_height;
+extern int view_width;
+extern int view_y;
+extern int view_x;
+
+void init_colors();
+bool render_open(const GameState *g, int start_y, int start_x, int height, int width);
+void render_close();
+void render_present();
+void draw_border(const GameState *g);
+chtype head_glyph(const GameState *g);
+void draw_segment(const GameState *g, Point p, bool is_head);
+void draw_food(const GameState *g);
+void draw_visible(const GameState *g);
+bool update_camera(const GameState *g, bool force);
+void draw_hud(const GameState *g, bool label_only);
+void draw_status(const char *text);
+void draw_full_frame(const GameState *g);
+void draw_changes(const GameState *g, Point old_head, Point old_tail, int old_length, Point old_food);
+
+#endif
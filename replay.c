@@ -0,0 +1,221 @@
+#define _POSIX_C_SOURCE 200809L // fileno, ftruncate
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "replay.h"
+
+#define MAX_VARINT_BYTES 10 // Enough for any uint64_t
+
+/*
+ * Functionality: Serializes a header into out (REPLAY_HEADER_SIZE bytes).
+ */
+void replay_encode_header(const ReplayHeader *h, uint8_t *out) {
+    memcpy(out, REPLAY_MAGIC, 4);
+    out[4] = REPLAY_VERSION;
+    out[5] = (uint8_t)h->start_dir;
+    put_le(out + 6, 0, 2);
+    put_le(out + 8, (uint32_t)h->pit_height, 4);
+    put_le(out + 12, (uint32_t)h->pit_width, 4);
+    put_le(out + 16, (uint32_t)h->target_length, 4);
+    put_le(out + 20, (uint32_t)h->final_length, 4);
+    put_le(out + 24, (uint64_t)h->ticks, 8);
+    put_le(out + 32, h->seed, 8);
+}
+
+/*
+ * Functionality: Parses a header from the first size bytes of in. Returns false if the
+ * bytes are not a replay this version understands.
+ */
+bool replay_decode_header(const uint8_t *in, size_t size, ReplayHeader *h) {
+    if (size < REPLAY_HEADER_SIZE || memcmp(in, REPLAY_MAGIC, 4) != 0 ||
+        in[4] != REPLAY_VERSION || in[5] > RIGHT) {
+        return false;
+    }
+    h->start_dir = (Direction)in[5];
+    h->pit_height = (int)get_le(in + 8, 4);
+    h->pit_width = (int)get_le(in + 12, 4);
+    h->target_length = (int)get_le(in + 16, 4);
+    h->final_length = (int)get_le(in + 20, 4);
+    h->ticks = (long)get_le(in + 24, 8);
+    h->seed = get_le(in + 32, 8);
+    return true;
+}
+
+/*
+ * Functionality: Writes value as a LEB128 varint (7 bits per byte, high bit = more to
+ * come) to out. Returns the number of bytes written, at most MAX_VARINT_BYTES.
+ */
+size_t replay_put_varint(uint8_t *out, uint64_t value) {
+    size_t n = 0;
+    while (value >= 0x80) {
+        out[n++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[n++] = (uint8_t)value;
+    return n;
+}
+
+/*
+ * Functionality: Writes the placeholder header for freshly initialized game g at the
+ * current file position and resets the direction tracking.
+ */
+static bool write_start(ReplayWriter *w, const GameState *g) {
+    memset(&w->header, 0, sizeof(w->header));
+    w->header.pit_height = g->pit_height;
+    w->header.pit_width = g->pit_width;
+    w->header.target_length = g->snake.max_length;
+    w->header.seed = g->seed;
+    w->header.start_dir = g->snake.dir;
+    w->last_tick = g->ticks;
+    w->last_dir = g->snake.dir;
+
+    uint8_t buf[REPLAY_HEADER_SIZE];
+    replay_encode_header(&w->header, buf);
+    return fwrite(buf, sizeof(buf), 1, w->file) == 1;
+}
+
+/*
+ * Functionality: Starts recording game g, which must be freshly initialized, to path.
+ * The header is written as a placeholder and completed by replay_close().
+ */
+bool replay_open(ReplayWriter *w, const char *path, const GameState *g) {
+    w->file = fopen(path, "wb");
+    if (!w->file) return false;
+    return write_start(w, g);
+}
+
+/*
+ * Functionality: Discards what has been recorded and starts the log over for g, which must
+ * be freshly reset, keeping the open file and its buffer. Does nothing when not recording.
+ * Returns false if the file could not be rewritten.
+ */
+bool replay_restart(ReplayWriter *w, const GameState *g) {
+    if (!w->file) return true;
+    if (fflush(w->file) != 0 || ftruncate(fileno(w->file), 0) != 0) return false;
+    rewind(w->file);
+    return write_start(w, g);
+}
+
+/*
+ * Functionality: Call just before each game_step() with the direction already applied
+ * to g->snake.dir; appends an entry if the direction changed since the last one.
+ */
+bool replay_record(ReplayWriter *w, const GameState *g) {
+    if (!w->file || g->snake.dir == w->last_dir) return true;
+
+    uint8_t buf[MAX_VARINT_BYTES];
+    uint64_t delta = (uint64_t)(g->ticks - w->last_tick);
+    size_t n = replay_put_varint(buf, delta << 2 | (uint64_t)g->snake.dir);
+    w->last_tick = g->ticks;
+    w->last_dir = g->snake.dir;
+    return fwrite(buf, n, 1, w->file) == 1;
+}
+
+/*
+ * Functionality: Fills in the header with the game's final tick count and length and
+ * closes the file. Returns false if any write failed.
+ */
+bool replay_close(ReplayWriter *w, const GameState *g) {
+    if (!w->file) return true;
+    w->header.ticks = g->ticks;
+    w->header.final_length = g->snake.length;
+
+    uint8_t buf[REPLAY_HEADER_SIZE];
+    replay_encode_header(&w->header, buf);
+    bool ok = fseek(w->file, 0, SEEK_SET) == 0 && fwrite(buf, sizeof(buf), 1, w->file) == 1;
+    ok = fclose(w->file) == 0 && ok;
+    w->file = NULL;
+    return ok;
+}
+
+/*
+ * Functionality: Reads the replay at path. Returns a malloc'd buffer of its entries
+ * (free with free()) and fills in h and entries_size, or NULL on error.
+ */
+uint8_t *replay_load(const char *path, ReplayHeader *h, size_t *entries_size) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return NULL;
+
+    uint8_t head[REPLAY_HEADER_SIZE];
+    uint8_t *entries = NULL;
+    long end;
+    if (fread(head, sizeof(head), 1, f) != 1 || !replay_decode_header(head, sizeof(head), h) ||
+        fseek(f, 0, SEEK_END) != 0 || (end = ftell(f)) < REPLAY_HEADER_SIZE ||
+        fseek(f, REPLAY_HEADER_SIZE, SEEK_SET) != 0) {
+        fclose(f);
+        return NULL;
+    }
+
+    *entries_size = (size_t)(end - REPLAY_HEADER_SIZE);
+    entries = (uint8_t *)malloc(*entries_size ? *entries_size : 1);
+    if (entries && *entries_size && fread(entries, *entries_size, 1, f) != 1) {
+        free(entries);
+        entries = NULL;
+    }
+    fclose(f);
+    return entries;
+}
+
+/*
+ * Functionality: Points r at a buffer of encoded entries, positioned before the first.
+ */
+void replay_reader_init(ReplayReader *r, const uint8_t *data, size_t size) {
+    memset(r, 0, sizeof(*r));
+    r->data = data;
+    r->size = size;
+}
+
+/*
+ * Functionality: Decodes the next entry into (tick, dir). Returns false at the end of the
+ * buffer or on a truncated varint.
+ */
+bool replay_next(ReplayReader *r, long *tick, Direction *dir) {
+    uint64_t value = 0;
+    int shift = 0;
+    for (;;) {
+        if (r->pos >= r->size || shift >= 7 * MAX_VARINT_BYTES) return false;
+        uint8_t byte = r->data[r->pos++];
+        value |= (uint64_t)(byte & 0x7f) << shift;
+        shift += 7;
+        if (!(byte & 0x80)) break;
+    }
+    r->tick += (long)(value >> 2);
+    *tick = r->tick;
+    *dir = (Direction)(value & 3);
+    return true;
+}
+
+/*
+ * Functionality: Initializes g as the game the header describes, ready for replay_play().
+ */
+bool replay_start(GameState *g, const ReplayHeader *h) {
+    if (!game_init(g, h->pit_height, h->pit_width, h->seed)) return false;
+    game_set_target_length(g, h->target_length);
+    g->snake.dir = h->start_dir;
+    return true;
+}
+
+/*
+ * Functionality: Re-simulates g from its current tick up to until_tick (capped at the
+ * recorded length), applying the direction changes read from r. Returns false if the
+ * log is inconsistent with the game, i.e. an entry lies in the past.
+ */
+bool replay_play(GameState *g, ReplayReader *r, const ReplayHeader *h, long until_tick) {
+    if (until_tick > h->ticks) until_tick = h->ticks;
+
+    while (g->ticks < until_tick) {
+        if (!r->pending) {
+            r->pending = replay_next(r, &r->pending_tick, &r->pending_dir);
+        }
+        if (r->pending && r->pending_tick < g->ticks) return false;
+
+        Direction dir = g->snake.dir;
+        if (r->pending && r->pending_tick == g->ticks) {
+            dir = r->pending_dir;
+            r->pending = false;
+        }
+        if (!game_step(g, dir)) break;
+    }
+    return true;
+}
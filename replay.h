@@ -0,0 +1,73 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "game.h"
+#include "bytes.h"
+
+/*
+ * Replay logs. A game is fully determined by its seed, its settings and the
+ * direction it moved in on each tick, so a log stores just those: a fixed
+ * header followed by one entry per direction change. Each entry is a LEB128
+ * varint of (tick_delta << 2 | direction), where tick_delta counts ticks since
+ * the previous change; a typical turn costs one or two bytes.
+ *
+ * All header fields are little-endian:
+ *   magic "SNKR", version u8, start direction u8, reserved u16,
+ *   pit_height u32, pit_width u32, target_length u32, final_length u32,
+ *   ticks u64, seed u64
+ */
+
+#define REPLAY_MAGIC "SNKR"
+#define REPLAY_VERSION 1
+#define REPLAY_HEADER_SIZE 40
+
+typedef struct {
+    int pit_height;
+    int pit_width;
+    int target_length;  // Length that wins
+    int final_length;   // Snake length when the game ended
+    long ticks;         // Ticks the game ran before it ended or was quit
+    uint64_t seed;
+    Direction start_dir;
+} ReplayHeader;
+
+// Records one game as it is played
+typedef struct {
+    FILE *file;
+    ReplayHeader header;
+    long last_tick;     // Tick of the previous entry
+    Direction last_dir; // Direction in effect after the previous entry
+} ReplayWriter;
+
+// Decodes entries from an in-memory buffer (a loaded file or a mapped archive).
+// Plain data, so copying one saves a position to resume from later.
+typedef struct {
+    const uint8_t *data;
+    size_t size;
+    size_t pos;         // Offset of the next undecoded byte
+    long tick;          // Tick of the entry decoded last
+    bool pending;       // An entry was decoded but not applied yet
+    long pending_tick;
+    Direction pending_dir;
+} ReplayReader;
+
+bool replay_open(ReplayWriter *w, const char *path, const GameState *g);
+bool replay_restart(ReplayWriter *w, const GameState *g);
+bool replay_record(ReplayWriter *w, const GameState *g);
+bool replay_close(ReplayWriter *w, const GameState *g);
+
+void replay_encode_header(const ReplayHeader *h, uint8_t *out);
+bool replay_decode_header(const uint8_t *in, size_t size, ReplayHeader *h);
+size_t replay_put_varint(uint8_t *out, uint64_t value);
+uint8_t *replay_load(const char *path, ReplayHeader *h, size_t *entries_size);
+
+void replay_reader_init(ReplayReader *r, const uint8_t *data, size_t size);
+bool replay_next(ReplayReader *r, long *tick, Direction *dir);
+bool replay_start(GameState *g, const ReplayHeader *h);
+bool replay_play(GameState *g, ReplayReader *r, const ReplayHeader *h, long until_tick);
+
+#endif
@@ -0,0 +1,241 @@
+#define _POSIX_C_SOURCE 200809L // pread, ftruncate, pthread_condattr_setclock
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bytes.h"
+#include "results.h"
+
+/*
+ * Functionality: Writes all size bytes of buf to fd. Returns false on error.
+ */
+static bool write_all(int fd, const uint8_t *buf, size_t size) {
+    while (size > 0) {
+        ssize_t n = write(fd, buf, size);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        buf += n;
+        size -= (size_t)n;
+    }
+    return true;
+}
+
+/*
+ * Functionality: Encodes a result as one RESULTS_RECORD_SIZE record at out.
+ */
+static void encode_result(uint8_t *out, const GameResult *r) {
+    memset(out, 0, RESULTS_RECORD_SIZE);
+    put_le(out, r->seed, 8);
+    put_le(out + 8, (uint64_t)r->ticks, 8);
+    put_le(out + 16, (uint32_t)r->length, 4);
+    put_le(out + 20, (uint32_t)r->food, 4);
+    put_le(out + 24, (uint32_t)r->snake, 4);
+    out[28] = (uint8_t)r->outcome;
+}
+
+/*
+ * Functionality: Returns a spare buffer, emptied, or NULL if the writer holds them all.
+ * Call with the log locked.
+ */
+static ResultBuffer *take_buffer(ResultLog *log) {
+    ResultBuffer *b = log->spares;
+    if (!b) return NULL;
+    log->spares = b->next;
+    b->next = NULL;
+    b->used = 0;
+    return b;
+}
+
+/*
+ * Functionality: Queues the front buffer for the writer and starts a new one. Call with the
+ * log locked.
+ */
+static void queue_front(ResultLog *log) {
+    ResultBuffer *b = log->front;
+    if (log->queue_tail) {
+        log->queue_tail->next = b;
+    } else {
+        log->queue = b;
+    }
+    log->queue_tail = b;
+    log->front = take_buffer(log);
+}
+
+/*
+ * Functionality: Writer thread body: writes out each queued buffer in turn and makes it a
+ * spare again, queuing the front buffer itself when none has come for RESULTS_FLUSH_SEC and
+ * when stopped, until stopped with nothing left to write.
+ */
+static void *writer_main(void *arg) {
+    ResultLog *log = (ResultLog *)arg;
+    pthread_mutex_lock(&log->lock);
+    for (;;) {
+        if (!log->queue) {
+            bool flush = log->stop;
+            if (!flush) {
+                struct timespec deadline;
+                clock_gettime(CLOCK_MONOTONIC, &deadline);
+                deadline.tv_sec += RESULTS_FLUSH_SEC;
+                flush = pthread_cond_timedwait(&log->wake, &log->lock, &deadline) == ETIMEDOUT;
+            }
+            if (!flush || log->queue) continue;
+            if (!log->front || log->front->used == 0) {
+                if (log->stop) break;
+                continue;
+            }
+            queue_front(log);
+        }
+        ResultBuffer *b = log->queue;
+        log->queue = b->next;
+        if (!log->queue) log->queue_tail = NULL;
+        pthread_mutex_unlock(&log->lock);
+
+        bool ok = !log->failed &&
+                  write_all(log->fd, b->records, (size_t)b->used * RESULTS_RECORD_SIZE);
+
+        pthread_mutex_lock(&log->lock);
+        if (ok) {
+            log->written += b->used;
+        } else {
+            log->failed = true;
+            log->lost += b->used;
+        }
+        b->next = log->spares;
+        log->spares = b;
+    }
+    pthread_mutex_unlock(&log->lock);
+    return NULL;
+}
+
+/*
+ * Functionality: Frees every buffer the log holds.
+ */
+static void free_buffers(ResultLog *log) {
+    ResultBuffer *lists[] = { log->front, log->queue, log->spares };
+    for (int i = 0; i < 3; i++) {
+        while (lists[i]) {
+            ResultBuffer *next = lists[i]->next;
+            free(lists[i]);
+            lists[i] = next;
+        }
+    }
+}
+
+/*
+ * Functionality: Checks an existing log's header and cuts off a trailing part record, or
+ * writes the header to a new one. Returns false if the file is not a results log.
+ */
+static bool prepare_file(int fd) {
+    struct stat st;
+    if (fstat(fd, &st) != 0) return false;
+    uint8_t header[RESULTS_HEADER_SIZE] = {0};
+    if (st.st_size == 0) {
+        memcpy(header, RESULTS_MAGIC, 4);
+        put_le(header + 4, RESULTS_VERSION, 4);
+        put_le(header + 8, RESULTS_RECORD_SIZE, 4);
+        return write_all(fd, header, sizeof(header));
+    }
+    if (st.st_size < RESULTS_HEADER_SIZE ||
+        pread(fd, header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+        memcmp(header, RESULTS_MAGIC, 4) != 0 || get_le(header + 4, 4) != RESULTS_VERSION ||
+        get_le(header + 8, 4) != RESULTS_RECORD_SIZE) {
+        return false;
+    }
+    off_t partial = (st.st_size - RESULTS_HEADER_SIZE) % RESULTS_RECORD_SIZE;
+    return partial == 0 || ftruncate(fd, st.st_size - partial) == 0;
+}
+
+/*
+ * Functionality: Opens the log at path for appending, creating it if needed, and starts its
+ * writer thread. Returns false if it cannot be opened or is not a results log.
+ */
+bool results_open(ResultLog *log, const char *path) {
+    memset(log, 0, sizeof(*log));
+    log->path = path;
+    log->fd = open(path, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (log->fd < 0 || !prepare_file(log->fd)) {
+        if (log->fd >= 0) close(log->fd);
+        return false;
+    }
+    for (int i = 0; i < RESULTS_BUFFERS; i++) {
+        ResultBuffer *b = (ResultBuffer *)malloc(sizeof(ResultBuffer));
+        if (!b) {
+            free_buffers(log);
+            close(log->fd);
+            return false;
+        }
+        b->next = log->spares;
+        log->spares = b;
+    }
+    log->front = take_buffer(log);
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC); // Deadlines from clock_gettime()
+    pthread_cond_init(&log->wake, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_mutex_init(&log->lock, NULL);
+    if (pthread_create(&log->writer, NULL, writer_main, log) != 0) {
+        pthread_cond_destroy(&log->wake);
+        pthread_mutex_destroy(&log->lock);
+        free_buffers(log);
+        close(log->fd);
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Functionality: Queues one result. Never waits for IO or allocates: a full front buffer
+ * goes to the writer and the next result starts a spare one. If the writer holds every
+ * spare, the result is lost and counted.
+ */
+void results_add(ResultLog *log, const GameResult *r) {
+    uint8_t record[RESULTS_RECORD_SIZE];
+    encode_result(record, r);
+
+    pthread_mutex_lock(&log->lock);
+    if (!log->front) log->front = take_buffer(log);
+    ResultBuffer *b = log->front;
+    if (!b) {
+        log->lost++;
+    } else {
+        memcpy(b->records + (size_t)b->used * RESULTS_RECORD_SIZE, record, sizeof(record));
+        if (++b->used == RESULTS_BATCH) {
+            queue_front(log);
+            pthread_cond_signal(&log->wake);
+        }
+    }
+    pthread_mutex_unlock(&log->lock);
+}
+
+/*
+ * Functionality: Writes out every queued result, stops the writer, closes the file and
+ * reports the counts on stderr. Returns false if any result was lost.
+ */
+bool results_close(ResultLog *log) {
+    pthread_mutex_lock(&log->lock);
+    log->stop = true;
+    pthread_cond_signal(&log->wake);
+    pthread_mutex_unlock(&log->lock);
+    pthread_join(log->writer, NULL);
+
+    bool ok = close(log->fd) == 0 && !log->failed;
+    if (!ok) fprintf(stderr, "%s: write failed\n", log->path);
+    fprintf(stderr, "results: %ld written (%ld lost) to %s\n", log->written, log->lost,
+            log->path);
+    ok = ok && log->lost == 0;
+
+    pthread_cond_destroy(&log->wake);
+    pthread_mutex_destroy(&log->lock);
+    free_buffers(log);
+    memset(log, 0, sizeof(*log));
+    return ok;
+}
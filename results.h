@@ -0,0 +1,87 @@
+#ifndef RESULTS_H
+#define RESULTS_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Per-game results log: an append-only binary file of fixed-size records,
+ * one per finished game (snake_sim) or per snake life (snake_server), for
+ * batch runs too long or too numerous to judge from the final totals.
+ *
+ * Game threads never touch the file. A result is encoded into the front
+ * buffer under a short lock; the thread that fills it queues it for a writer
+ * thread and carries on in a spare one. The writer writes queued buffers out
+ * and returns them to the spares, and after RESULTS_FLUSH_SEC without a full
+ * buffer it queues the front one itself, so a quiet server's log stays
+ * current. All RESULTS_BUFFERS buffers are allocated when the log opens, so
+ * adding a result never allocates or waits, and the log's memory is fixed.
+ * If the disk falls that many buffers behind, results are lost and counted
+ * instead, as they are when a write fails; either fails results_close().
+ *
+ * Layout (all integers little-endian):
+ *   header: magic "SNKS", version u32, record size u32, reserved u32
+ *   record: seed u64, ticks u64, length u32, food u32, snake u32,
+ *           outcome u8, 3 zero bytes
+ *
+ * seed is the game's seed (the room's for the server), ticks how long the
+ * game or life lasted, length the final length, food the items eaten, and
+ * snake the player's id in its room (0 for a single-player game). Opening an
+ * existing log appends to it after checking its header, first cutting off
+ * any part record left by a run that was killed mid-write.
+ */
+
+#define RESULTS_MAGIC "SNKS"
+#define RESULTS_VERSION 1
+#define RESULTS_HEADER_SIZE 16
+#define RESULTS_RECORD_SIZE 32
+#define RESULTS_BATCH 4096         // Records per buffer
+#define RESULTS_BUFFERS 16         // Buffers, all allocated when the log opens
+#define RESULTS_FLUSH_SEC 1        // Longest a record waits in a buffer
+
+typedef enum {
+    RESULT_LOSS,    // Crashed
+    RESULT_WIN,     // Reached the target length
+    RESULT_CAPPED,  // Stopped at the tick cap, still alive
+    RESULT_LEFT     // Disconnected while alive (server only)
+} ResultOutcome;
+
+typedef struct {
+    uint64_t seed;
+    long ticks;
+    int length;
+    int food;
+    int snake;
+    ResultOutcome outcome;
+} GameResult;
+
+typedef struct ResultBuffer ResultBuffer;
+
+struct ResultBuffer {
+    ResultBuffer *next;      // In the writer's queue or the spares
+    int used;                // Records so far
+    uint8_t records[RESULTS_BATCH * RESULTS_RECORD_SIZE];
+};
+
+typedef struct {
+    int fd;
+    const char *path;
+    ResultBuffer *front;     // Being filled; NULL while the writer holds every buffer
+    ResultBuffer *queue;     // Full buffers for the writer, oldest first ...
+    ResultBuffer *queue_tail; // ... and the newest
+    ResultBuffer *spares;    // Empty buffers
+    bool stop;
+    bool failed;             // A write failed; what it held counts as lost
+    long written;
+    long lost;
+    pthread_mutex_t lock;    // Guards everything from front on
+    pthread_cond_t wake;     // A full buffer was queued, or stop
+    pthread_t writer;
+} ResultLog;
+
+bool results_open(ResultLog *log, const char *path);
+void results_add(ResultLog *log, const GameResult *r);
+bool results_close(ResultLog *log);
+
+#endif
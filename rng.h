@@ -0,0 +1,101 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+/*
+ * Small per-game PRNG. Each GameState owns one, so games never share hidden
+ * state and any game can be reproduced from its 64-bit seed. The generator
+ * is PCG32 by default; build with -DSNAKE_RNG_XOSHIRO for xoshiro256**.
+ * Both are seeded through splitmix64 so nearby seeds give unrelated streams.
+ */
+
+#ifdef SNAKE_RNG_XOSHIRO
+typedef struct {
+    uint64_t s[4];
+} Rng;
+#else
+typedef struct {
+    uint64_t state;
+    uint64_t inc;   // Stream selector, always odd
+} Rng;
+#endif
+
+/*
+ * Functionality: Advances a splitmix64 state and returns the next output.
+ */
+static inline uint64_t splitmix64(uint64_t *x) {
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+#ifdef SNAKE_RNG_XOSHIRO
+static inline uint64_t rng_rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+/*
+ * Functionality: Seeds the generator deterministically from a 64-bit seed.
+ */
+static inline void rng_seed(Rng *r, uint64_t seed) {
+    for (int i = 0; i < 4; i++) {
+        r->s[i] = splitmix64(&seed);
+    }
+}
+
+/*
+ * Functionality: Returns the next 32 random bits (high half of a xoshiro256** output).
+ */
+static inline uint32_t rng_next(Rng *r) {
+    uint64_t *s = r->s;
+    uint64_t result = rng_rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rng_rotl(s[3], 45);
+    return (uint32_t)(result >> 32);
+}
+#else
+/*
+ * Functionality: Seeds the generator deterministically from a 64-bit seed.
+ */
+static inline void rng_seed(Rng *r, uint64_t seed) {
+    r->state = splitmix64(&seed);
+    r->inc = splitmix64(&seed) | 1;
+}
+
+/*
+ * Functionality: Returns the next 32 random bits (PCG-XSH-RR).
+ */
+static inline uint32_t rng_next(Rng *r) {
+    uint64_t old = r->state;
+    r->state = old * 6364136223846793005ULL + r->inc;
+    uint32_t xorshifted = (uint32_t)(((old >> 18) ^ old) >> 27);
+    uint32_t rot = (uint32_t)(old >> 59);
+    return (xorshifted >> rot) | (xorshifted << ((32 - rot) & 31));
+}
+#endif
+
+/*
+ * Functionality: Returns a uniform integer in [0, bound) without modulo bias, using
+ * Lemire's multiply-and-reject method (one multiply and almost never a retry).
+ */
+static inline uint32_t rng_below(Rng *r, uint32_t bound) {
+    uint64_t m = (uint64_t)rng_next(r) * bound;
+    uint32_t low = (uint32_t)m;
+    if (low < bound) {
+        uint32_t threshold = (uint32_t)(-bound) % bound;
+        while (low < threshold) {
+            m = (uint64_t)rng_next(r) * bound;
+            low = (uint32_t)m;
+        }
+    }
+    return (uint32_t)(m >> 32);
+}
+
+#endif
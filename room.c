@@ -0,0 +1,327 @@
+#include <string.h>
+
+#include "room.h"
+
+#define SPAWN_TRIES 64 // Random picks for a spawn cell before waiting for the next tick
+#define FOOD_TRIES 16  // Random picks for a food cell before retrying next tick
+
+static const int dx[4] = { 0, 0, -1, 1 }; // Indexed by Direction
+static const int dy[4] = { -1, 1, 0, 0 };
+
+/*
+ * Functionality: Appends an event and returns it. The list is sized so a tick can never
+ * overflow it; should it fill up anyway, returns NULL.
+ */
+static RoomEvent *push_event(Room *r, RoomEventKind kind, int snake, Point at) {
+    if (r->event_count == r->event_capacity) return NULL;
+    RoomEvent *e = &r->events[r->event_count++];
+    *e = (RoomEvent){ .kind = kind, .snake = snake, .at = at };
+    return e;
+}
+
+/*
+ * Functionality: Returns the grid index for window-local coords (x, y).
+ */
+static inline int room_cell(const Room *r, int x, int y) {
+    return y * r->grid_stride + x;
+}
+
+/*
+ * Functionality: Returns true if (x, y) is an empty pit cell without food.
+ */
+static bool cell_is_empty(const Room *r, int x, int y) {
+    if (x < 1 || x > r->pit_width || y < 1 || y > r->pit_height) return false;
+    int cell = room_cell(r, x, y);
+    return r->cell_owner[cell] == 0 && r->food_pos[cell] == 0;
+}
+
+/*
+ * Functionality: Allocates a room for up to max_snakes players on a pit_height x pit_width
+ * pit. Every snake gets a body ring able to hold the whole pit; the reservation only
+ * commits the pages snakes actually grow into. Returns false if the size is out of
+ * range or the reservation fails.
+ */
+bool room_init(Room *r, int pit_height, int pit_width, int max_snakes, uint64_t seed) {
+    memset(r, 0, sizeof(*r));
+    if (pit_height < MIN_PIT_SIDE || pit_height > MAX_PIT_SIDE || pit_width < MIN_PIT_SIDE ||
+        pit_width > MAX_PIT_SIDE || max_snakes < 1 || max_snakes > ROOM_MAX_SNAKES) {
+        return false;
+    }
+    r->pit_height = pit_height;
+    r->pit_width = pit_width;
+    r->grid_stride = pit_width + 2;
+    r->max_snakes = max_snakes;
+    r->food_capacity = 1 + max_snakes / ROOM_SNAKES_PER_FOOD;
+    // Per snake and tick: a leave's death, then a move (head and tail) or death, then a spawn
+    r->event_capacity = 4 * max_snakes + r->food_capacity;
+    rng_seed(&r->rng, seed);
+
+    size_t grid_size = (size_t)(pit_height + 2) * r->grid_stride;
+    size_t ring = (size_t)pit_height * pit_width + 1;
+    size_t reserve = arena_round(grid_size * sizeof(uint16_t)) * 2 +
+                     arena_round(grid_size * sizeof(uint32_t)) + arena_round(grid_size * sizeof(int)) +
+                     arena_round(r->food_capacity * sizeof(Point)) +
+                     arena_round(max_snakes * sizeof(RoomSnake)) +
+                     arena_round(r->event_capacity * sizeof(RoomEvent)) +
+                     max_snakes * arena_round(ring * sizeof(Point));
+    if (!arena_init(&r->arena, reserve)) return false;
+
+    r->cell_owner = (uint16_t *)arena_alloc(&r->arena, grid_size * sizeof(uint16_t));
+    r->claim_tick = (uint32_t *)arena_alloc(&r->arena, grid_size * sizeof(uint32_t));
+    r->claim_id = (uint16_t *)arena_alloc(&r->arena, grid_size * sizeof(uint16_t));
+    r->food_pos = (int *)arena_alloc(&r->arena, grid_size * sizeof(int));
+    r->food = (Point *)arena_alloc(&r->arena, r->food_capacity * sizeof(Point));
+    r->snakes = (RoomSnake *)arena_alloc(&r->arena, max_snakes * sizeof(RoomSnake));
+    r->events = (RoomEvent *)arena_alloc(&r->arena, r->event_capacity * sizeof(RoomEvent));
+    for (int i = 0; i < max_snakes; i++) {
+        r->snakes[i].snake.body = (Point *)arena_alloc(&r->arena, ring * sizeof(Point));
+        r->snakes[i].snake.capacity = (int)ring;
+    }
+
+    // The border ring has an owner too, so a head on it is a collision like any other
+    for (int x = 0; x < r->grid_stride; x++) {
+        r->cell_owner[room_cell(r, x, 0)] = ROOM_WALL;
+        r->cell_owner[room_cell(r, x, pit_height + 1)] = ROOM_WALL;
+    }
+    for (int y = 1; y <= pit_height; y++) {
+        r->cell_owner[room_cell(r, 0, y)] = ROOM_WALL;
+        r->cell_owner[room_cell(r, pit_width + 1, y)] = ROOM_WALL;
+    }
+    return true;
+}
+
+/*
+ * Functionality: Empties a room for reuse with a new seed, keeping all its memory: only the
+ * cells the old snakes and food were on are cleared, so it costs what the old game held.
+ */
+void room_reset(Room *r, uint64_t seed) {
+    for (int id = 0; id < r->max_snakes; id++) {
+        RoomSnake *s = &r->snakes[id];
+        for (int i = 0; i < s->snake.length; i++) {
+            Point *seg = room_segment(s, i);
+            r->cell_owner[room_cell(r, seg->x, seg->y)] = 0;
+        }
+        s->snake.length = 0;
+        s->snake.head = 0;
+        s->in_use = false;
+        s->alive = false;
+    }
+    for (int i = 0; i < r->food_count; i++) {
+        r->food_pos[room_cell(r, r->food[i].x, r->food[i].y)] = 0;
+    }
+    r->food_count = 0;
+    r->alive_count = 0;
+    r->event_count = 0;
+    r->ticks = 0;
+    rng_seed(&r->rng, seed);
+    // Claim stamps are tick + 1, and ticks restart: clear them so old ones cannot match
+    memset(r->claim_tick, 0, (size_t)(r->pit_height + 2) * r->grid_stride * sizeof(uint32_t));
+}
+
+/*
+ * Functionality: Releases the memory owned by a room.
+ */
+void room_free(Room *r) {
+    arena_free(&r->arena);
+    memset(r, 0, sizeof(*r));
+}
+
+/*
+ * Functionality: Takes a snake off the board, freeing its cells, and records its death with
+ * the life that ended; left says its player is leaving.
+ */
+static void kill_snake(Room *r, int id, bool left) {
+    RoomSnake *s = &r->snakes[id];
+    for (int i = 0; i < s->snake.length; i++) {
+        Point *seg = room_segment(s, i);
+        r->cell_owner[room_cell(r, seg->x, seg->y)] = 0;
+    }
+    RoomEvent *e = push_event(r, EVENT_DEATH, id, (Point){ 0, 0 });
+    if (e) e->life = (RoomLife){ r->ticks - s->spawn_tick, s->snake.length, s->eaten, left };
+    s->snake.length = 0;
+    s->alive = false;
+    s->respawn_tick = r->ticks + ROOM_RESPAWN_TICKS;
+    r->alive_count--;
+}
+
+/*
+ * Functionality: Places a dead player's snake as one cell on a random empty cell with an
+ * empty cell ahead of it; it grows to ROOM_SPAWN_LENGTH as it moves. Returns false if no
+ * such cell turned up, in which case it tries again next tick.
+ */
+static bool spawn_snake(Room *r, int id) {
+    for (int i = 0; i < SPAWN_TRIES; i++) {
+        int x = (int)rng_below(&r->rng, (uint32_t)r->pit_width) + 1;
+        int y = (int)rng_below(&r->rng, (uint32_t)r->pit_height) + 1;
+        Direction dir = (Direction)rng_below(&r->rng, 4);
+        if (!cell_is_empty(r, x, y) || !cell_is_empty(r, x + dx[dir], y + dy[dir])) continue;
+
+        RoomSnake *s = &r->snakes[id];
+        s->snake.head = 0;
+        s->snake.length = 1;
+        s->snake.body[0] = (Point){ x, y };
+        s->snake.dir = dir;
+        s->next_dir = dir;
+        s->grow = ROOM_SPAWN_LENGTH - 1;
+        s->alive = true;
+        s->spawn_tick = r->ticks;
+        s->eaten = 0;
+        r->cell_owner[room_cell(r, x, y)] = (uint16_t)(id + 1);
+        r->alive_count++;
+        push_event(r, EVENT_SPAWN, id, (Point){ x, y });
+        return true;
+    }
+    return false;
+}
+
+/*
+ * Functionality: Claims a free player slot. Its snake spawns on the next room_step().
+ * Returns the snake id, or -1 if the room is full.
+ */
+int room_join(Room *r) {
+    for (int id = 0; id < r->max_snakes; id++) {
+        RoomSnake *s = &r->snakes[id];
+        if (s->in_use) continue;
+        s->in_use = true;
+        s->alive = false;
+        s->snake.length = 0;
+        s->respawn_tick = r->ticks;
+        return id;
+    }
+    return -1;
+}
+
+/*
+ * Functionality: Frees a player slot, removing its snake from the board.
+ */
+void room_leave(Room *r, int id) {
+    RoomSnake *s = &r->snakes[id];
+    if (!s->in_use) return;
+    if (s->alive) kill_snake(r, id, true);
+    s->in_use = false;
+}
+
+/*
+ * Functionality: Sets the direction a snake moves in on the next tick. Reversing into the
+ * neck is ignored, as in game_turn().
+ */
+void room_turn(Room *r, int id, Direction dir) {
+    RoomSnake *s = &r->snakes[id];
+    if (!s->alive || (s->snake.length > 1 && is_opposite(s->snake.dir, dir))) return;
+    s->next_dir = dir;
+}
+
+/*
+ * Functionality: Picks each live snake's target cell and claims it for the tick. The second
+ * head to claim a cell finds the first one's stamp, and both die head to head.
+ */
+static void claim_targets(Room *r) {
+    uint32_t stamp = (uint32_t)r->ticks + 1;
+    for (int id = 0; id < r->max_snakes; id++) {
+        RoomSnake *s = &r->snakes[id];
+        if (!s->alive) continue;
+        Point head = *room_segment(s, 0);
+        s->snake.dir = s->next_dir;
+        s->target = room_cell(r, head.x + dx[s->snake.dir], head.y + dy[s->snake.dir]);
+        s->dying = false;
+        if (r->claim_tick[s->target] == stamp) {
+            s->dying = true;
+            r->snakes[r->claim_id[s->target]].dying = true;
+        } else {
+            r->claim_tick[s->target] = stamp;
+            r->claim_id[s->target] = (uint16_t)id;
+        }
+    }
+}
+
+/*
+ * Functionality: Drops the tail of every live snake that is not growing, so heads may move
+ * into cells tails leave in the same tick.
+ */
+static void move_tails(Room *r) {
+    for (int id = 0; id < r->max_snakes; id++) {
+        RoomSnake *s = &r->snakes[id];
+        if (!s->alive || s->grow > 0) continue;
+        Point tail = *room_segment(s, s->snake.length - 1);
+        r->cell_owner[room_cell(r, tail.x, tail.y)] = 0;
+        s->snake.length--;
+        push_event(r, EVENT_TAIL, id, tail);
+    }
+}
+
+/*
+ * Functionality: Moves each surviving head into its target, which must now be empty; a head
+ * meeting a wall or any body (its own included) dies. Eating grows the snake by one.
+ */
+static void move_heads(Room *r) {
+    for (int id = 0; id < r->max_snakes; id++) {
+        RoomSnake *s = &r->snakes[id];
+        if (!s->alive) continue;
+        int cell = s->target;
+        if (s->dying || r->cell_owner[cell] != 0) {
+            s->dying = true;
+            continue;
+        }
+
+        if (s->grow > 0) s->grow--;
+        s->snake.head = (s->snake.head == 0) ? s->snake.capacity - 1 : s->snake.head - 1;
+        Point new_head = { cell % r->grid_stride, cell / r->grid_stride };
+        s->snake.body[s->snake.head] = new_head;
+        s->snake.length++;
+        r->cell_owner[cell] = (uint16_t)(id + 1);
+        push_event(r, EVENT_HEAD, id, new_head);
+
+        // Eat: swap-remove the food, grow by one
+        int pos = r->food_pos[cell] - 1;
+        if (pos >= 0) {
+            Point last = r->food[--r->food_count];
+            r->food[pos] = last;
+            r->food_pos[room_cell(r, last.x, last.y)] = pos + 1;
+            r->food_pos[cell] = 0;
+            s->grow++;
+            s->eaten++;
+        }
+    }
+}
+
+/*
+ * Functionality: Tops the food up to one item plus one per ROOM_SNAKES_PER_FOOD live snakes.
+ */
+static void refill_food(Room *r) {
+    int target = 1 + r->alive_count / ROOM_SNAKES_PER_FOOD;
+    if (target > r->food_capacity) target = r->food_capacity;
+    for (int tries = 0; r->food_count < target && tries < FOOD_TRIES; tries++) {
+        int x = (int)rng_below(&r->rng, (uint32_t)r->pit_width) + 1;
+        int y = (int)rng_below(&r->rng, (uint32_t)r->pit_height) + 1;
+        if (!cell_is_empty(r, x, y)) continue;
+        r->food[r->food_count] = (Point){ x, y };
+        r->food_pos[room_cell(r, x, y)] = ++r->food_count;
+        push_event(r, EVENT_FOOD, 0, (Point){ x, y });
+    }
+}
+
+/*
+ * Functionality: Advances the room one tick: moves every live snake at once and removes the
+ * ones that crashed, respawns players whose wait is over, and tops up the food.
+ */
+void room_step(Room *r) {
+    claim_targets(r);
+    move_tails(r);
+    move_heads(r);
+    for (int id = 0; id < r->max_snakes; id++) {
+        if (r->snakes[id].alive && r->snakes[id].dying) kill_snake(r, id, false);
+    }
+    r->ticks++;
+    for (int id = 0; id < r->max_snakes; id++) {
+        RoomSnake *s = &r->snakes[id];
+        if (s->in_use && !s->alive && r->ticks >= s->respawn_tick) spawn_snake(r, id);
+    }
+    refill_food(r);
+}
+
+/*
+ * Functionality: Forgets the queued events, once they have been broadcast.
+ */
+void room_clear_events(Room *r) {
+    r->event_count = 0;
+}
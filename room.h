@@ -0,0 +1,113 @@
+#ifndef ROOM_H
+#define ROOM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "arena.h"
+#include "game.h"
+#include "rng.h"
+
+/*
+ * Multiplayer pit: many snakes sharing one board, for snake_server. Uses the
+ * same coordinates, directions and body ring as the single-player core, but
+ * there is no win condition and dead players respawn after ROOM_RESPAWN_TICKS.
+ *
+ * Collisions never compare bodies: one grid records which snake, if any, is
+ * on each cell, so a head's fate is a single lookup. All snakes move at once.
+ * A tick first claims every head's target cell in a second grid stamped with
+ * the tick, which catches two heads entering the same cell (both die) in one
+ * pass over the snakes; then tails leave and each head dies if its target is
+ * still owned. The tick costs O(snakes), however long they are.
+ *
+ * Every change to the board is also appended to an event list, so a server
+ * can broadcast what happened each tick instead of the whole board: a spawn
+ * (one-cell snake at x, y), a new head, a removed tail, a death (the snake's
+ * whole body is gone; the event also holds the life that ended) and new food. Eaten food has no event of its own; it is
+ * the food under a new head. Events queue up until room_clear_events().
+ */
+
+#define ROOM_MAX_SNAKES 65534    // Snake ids travel as u16; ROOM_WALL marks the border
+#define ROOM_WALL 0xffff         // cell_owner value of the border ring
+#define ROOM_SPAWN_LENGTH 3      // A spawned snake starts as one cell and grows to this
+#define ROOM_RESPAWN_TICKS 10    // Ticks a dead player waits before respawning
+#define ROOM_SNAKES_PER_FOOD 4   // Food kept on the board: one, plus one per this many snakes
+
+typedef enum {
+    EVENT_SPAWN,
+    EVENT_HEAD,
+    EVENT_TAIL,
+    EVENT_DEATH,
+    EVENT_FOOD
+} RoomEventKind;
+
+// A snake's life, as of its death
+typedef struct {
+    long ticks;       // Ticks survived
+    int length;       // Length it died at
+    int eaten;        // Food eaten
+    bool left;        // Its player left, rather than it crashing
+} RoomLife;
+
+typedef struct {
+    RoomEventKind kind;
+    int snake;        // Snake id (unused for EVENT_FOOD)
+    Point at;         // Cell concerned (unused for EVENT_DEATH)
+    RoomLife life;    // EVENT_DEATH only
+} RoomEvent;
+
+// One player's slot. The slot outlives deaths; only room_leave() frees it.
+typedef struct {
+    Snake snake;      // Body ring with room for every pit cell
+    Direction next_dir; // Direction for the next tick, set by room_turn()
+    int grow;         // Segments still to add before the tail moves again
+    bool in_use;
+    bool alive;
+    bool dying;       // Lost a collision this tick
+    int target;       // Cell the head enters this tick
+    long respawn_tick; // Tick at which a dead player comes back
+    long spawn_tick;  // Tick the current life began ...
+    int eaten;        // ... and the food eaten in it, for its death's RoomLife
+} RoomSnake;
+
+typedef struct {
+    int pit_height;
+    int pit_width;
+    int grid_stride;
+    uint16_t *cell_owner;     // Per cell: id + 1 of the snake on it, 0 if empty, ROOM_WALL
+    uint32_t *claim_tick;     // Per cell: tick + 1 when a head last targeted it ...
+    uint16_t *claim_id;       // ... and which snake's head that was
+    int *food_pos;            // Per cell: index in food plus one, 0 when no food
+    Point *food;
+    int food_count;
+    int food_capacity;
+    RoomSnake *snakes;
+    int max_snakes;
+    int alive_count;
+    long ticks;
+    Rng rng;
+    RoomEvent *events;
+    int event_count;
+    int event_capacity;
+    Arena arena;              // Backs every buffer above
+} Room;
+
+bool room_init(Room *r, int pit_height, int pit_width, int max_snakes, uint64_t seed);
+void room_reset(Room *r, uint64_t seed);
+void room_free(Room *r);
+int room_join(Room *r);
+void room_leave(Room *r, int id);
+void room_turn(Room *r, int id, Direction dir);
+void room_step(Room *r);
+void room_clear_events(Room *r);
+
+/*
+ * Functionality: Returns segment i of snake s (0 = head, length - 1 = tail).
+ */
+static inline Point *room_segment(const RoomSnake *s, int i) {
+    int idx = s->snake.head + i;
+    if (idx >= s->snake.capacity) idx -= s->snake.capacity;
+    return &s->snake.body[idx];
+}
+
+#endif
@@ -0,0 +1,883 @@
+#define _GNU_SOURCE // accept4, SOCK_NONBLOCK, signalfd
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "alloc.h"
+#include "ansi.h"
+#include "game.h"
+#include "room.h"
+#include "net.h"
+#include "results.h"
+#include "spectate.h"
+
+/*
+ * Multiplayer server: thousands of independent rooms (see room.h), each a
+ * shared pit for up to max_players snakes, spread across worker threads.
+ *
+ * One IO thread owns the sockets. It accepts players into the newest room
+ * with a free seat, opening a room when all are full, and applies their turn
+ * keys. Every room is owned by one worker, which steps it each tick and sends
+ * its clients the tick's packet (see net.h), one send() per client. A worker
+ * that finishes its own rooms early steals not-yet-stepped rooms from the
+ * worker with the most left, and takes them over when that worker owns more
+ * rooms than it does, so load drifts towards idle cores without rooms
+ * bouncing between evenly loaded ones. A room is locked while it is stepped
+ * and while the IO thread touches it; that lock is the only contention
+ * between threads in normal operation.
+ *
+ * Every room, its clients and their output buffers come from a slab built
+ * at startup, so opening and closing rooms never allocates. Rooms that lose
+ * their last player go back to the slab.
+ *
+ * With -w, spectators connecting to a second port watch the busiest room as
+ * an ANSI stream (see spectate.h). A room being watched borrows one of
+ * SPECTATED_ROOMS broadcasters, also built at startup, and its worker renders
+ * and sends the room's frame after stepping it.
+ *
+ * With -o, every snake's life is appended to a results log (see results.h)
+ * when it dies or its player leaves, by a writer thread of its own.
+ *
+ * Usage: snake_server [-p port] [-s HxW] [-n max_players] [-r max_rooms] [-j workers]
+ *                     [-t tick_ms] [-S seed] [-w spectator_port] [-o results_file]
+ */
+
+#define DEFAULT_PORT 7777
+#define DEFAULT_TICK_MS 100        // The single-player game's pace (10 moves/sec)
+#define MAX_CATCHUP_TICKS 5        // Ticks a room runs at most per turn before dropping behind
+#define CLIENT_BACKLOG (64 << 10)  // Unsent bytes a client may fall behind by, beyond a snapshot
+#define MAX_EPOLL_EVENTS 256
+#define SPECTATED_ROOMS 8          // Rooms that can be watched at once
+#define ROOM_SPECTATORS 64         // Spectators per watched room
+#define SPECTATOR_ROWS 24          // Spectators' screen size
+#define SPECTATOR_COLS 80
+
+typedef struct ServerRoom ServerRoom;
+
+typedef struct {
+    AnsiRenderer screen;   // Renders the room once for all its spectators
+    Spectate spectators;
+    ServerRoom *room;      // The room watched, NULL while in the pool
+} Broadcast;
+
+struct ServerRoom {
+    Room room;
+    Client *clients;       // max_players, indexed by snake id
+    Arena arena;           // Backs the clients and their output buffers
+    pthread_mutex_t lock;  // Held while stepping and by the IO thread for joins, leaves and turns
+    int players;
+    bool retired;          // Emptied and off the open list; back to the slab at the next tick
+    long epoch;            // Server tick the room opened at
+    uint64_t seed;         // The room's seed, for the results log
+    int slot;              // Index in the slab
+    Broadcast *broadcast;  // Set while the room is watched; changed with both locks held
+};
+
+typedef struct Server Server;
+
+typedef struct {
+    Server *server;
+    int index;
+    pthread_t thread;
+    pthread_mutex_t lock;  // Guards owned, count, head, tail and tick
+    ServerRoom **owned;    // Rooms this worker steps
+    int count;
+    int head;              // owned[head..tail) are still to step this tick: the owner
+    int tail;              // takes from the tail, thieves from the head
+    long tick;             // Server tick the worker is stepping its rooms to
+    uint8_t *packet;       // Scratch for encoding a tick packet
+    long steps;            // Room ticks run, for the exit report
+    long steals;           // Rooms stepped for other workers
+    long moved;            // Of those, rooms taken over for good
+} Worker;
+
+struct Server {
+    pthread_mutex_t lock;  // Guards the slab and the open list; taken before any room lock
+    ServerRoom *slots;     // The slab
+    int slot_count;
+    int *free_slots;       // Stack of unused slot indices
+    int free_count;
+    ServerRoom **open;     // Rooms accepting players
+    int open_count;
+    Worker *workers;
+    int worker_count;
+    int max_players;
+    uint64_t seed;
+    uint64_t rooms_opened;
+    long long start_ns;
+    long long tick_ns;
+    int running;           // Cleared (atomically) on SIGINT/SIGTERM
+    Broadcast *broadcasts; // SPECTATED_ROOMS; guarded by the server lock except as above
+    int epoll_fd;
+    int listen_fd;
+    int signal_fd;
+    int spectator_fd;      // Listening for spectators, -1 without -w
+    ResultLog *results;    // Per-life log, NULL without -o
+};
+
+// Marks the listening and signal fds in the epoll set; clients carry their Client pointer
+static char listen_tag, signal_tag, spectator_tag;
+
+/*
+ * Functionality: Returns the monotonic clock in nanoseconds.
+ */
+static long long now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/*
+ * Functionality: Returns how many ticks have come due since the server started.
+ */
+static long current_tick(const Server *s) {
+    return (long)((now_ns() - s->start_ns) / s->tick_ns);
+}
+
+/*
+ * Functionality: Disconnects a client and frees its snake. IO thread only, with the room
+ * locked: only this thread closes sockets, so a worker never sends on a reused fd.
+ */
+static void drop_client(ServerRoom *sr, Client *c) {
+    if (c->fd < 0) return;
+    close(c->fd); // Also removes it from the epoll set
+    c->fd = -1;
+    room_leave(&sr->room, c->id);
+    sr->players--;
+}
+
+/*
+ * Functionality: Logs the life carried by every death among the room's queued events.
+ */
+static void record_deaths(const Server *s, const ServerRoom *sr) {
+    const Room *r = &sr->room;
+    for (int i = 0; s->results && i < r->event_count; i++) {
+        const RoomEvent *e = &r->events[i];
+        if (e->kind != EVENT_DEATH) continue;
+        GameResult result = {
+            .seed = sr->seed,
+            .ticks = e->life.ticks,
+            .length = e->life.length,
+            .food = e->life.eaten,
+            .snake = e->snake,
+            .outcome = e->life.left ? RESULT_LEFT : RESULT_LOSS,
+        };
+        results_add(s->results, &result);
+    }
+}
+
+/*
+ * Functionality: Runs one tick of a room, logs the lives that ended, and queues its packet
+ * for every client: the delta for clients already in sync, a snapshot of the state after
+ * the tick for new ones.
+ */
+static void step_room(Worker *w, ServerRoom *sr) {
+    Room *r = &sr->room;
+    room_step(r);
+    record_deaths(w->server, sr);
+    size_t size = net_encode_tick(r, w->packet);
+    for (int id = 0; id < r->max_snakes; id++) {
+        Client *c = &sr->clients[id];
+        if (c->fd < 0 || c->closing) continue;
+        if (!c->welcomed) {
+            net_queue_welcome(c, r);
+        } else {
+            net_queue(c, w->packet, size);
+        }
+    }
+    room_clear_events(r);
+    w->steps++;
+}
+
+/*
+ * Functionality: Renders a watched room's frame for its spectators, a keyframe too if any
+ * are waiting for one, and sends them what they have queued. Call with the room locked.
+ */
+static void broadcast_room(ServerRoom *sr, bool stepped) {
+    Broadcast *b = sr->broadcast;
+    if (!b || spectate_idle(&b->spectators)) return;
+    if (stepped) {
+        ansi_begin_frame(&b->screen);
+        ansi_draw_room(&b->screen, &sr->room);
+        spectate_publish(&b->spectators, &b->screen, false);
+        if (spectate_wants_keyframe(&b->spectators)) {
+            ansi_begin_frame(&b->screen);
+            ansi_clear(&b->screen);
+            ansi_draw_room(&b->screen, &sr->room);
+            spectate_publish(&b->spectators, &b->screen, true);
+        }
+    }
+    spectate_flush(&b->spectators);
+}
+
+/*
+ * Functionality: Brings a room up to server tick `tick` (at most MAX_CATCHUP_TICKS at once)
+ * and flushes its clients, one send() each, and its spectators. Clients that fail are shut
+ * down for the IO thread to drop. Returns true if the room has no players left.
+ */
+static bool run_room(Worker *w, ServerRoom *sr, long tick) {
+    pthread_mutex_lock(&sr->lock);
+    if (sr->retired) {
+        pthread_mutex_unlock(&sr->lock);
+        return false;
+    }
+    int steps = 0;
+    while (sr->room.ticks < tick - sr->epoch && steps < MAX_CATCHUP_TICKS) {
+        step_room(w, sr);
+        steps++;
+    }
+    for (int id = 0; id < sr->room.max_snakes; id++) {
+        Client *c = &sr->clients[id];
+        if (c->fd < 0) continue;
+        if (!net_flush(c, w->server->epoll_fd)) shutdown(c->fd, SHUT_RDWR);
+    }
+    broadcast_room(sr, steps > 0);
+    bool empty = sr->players == 0;
+    pthread_mutex_unlock(&sr->lock);
+    return empty;
+}
+
+/*
+ * Functionality: Takes an empty room off the open list so no player joins it; the owner
+ * returns it to the slab at its next tick. Leaves it alone if someone joined meanwhile.
+ */
+static void retire_room(Server *s, ServerRoom *sr) {
+    pthread_mutex_lock(&s->lock);
+    pthread_mutex_lock(&sr->lock);
+    if (sr->players == 0 && !sr->retired) {
+        __atomic_store_n(&sr->retired, true, __ATOMIC_RELEASE);
+        for (int i = 0; i < s->open_count; i++) {
+            if (s->open[i] == sr) {
+                s->open[i] = s->open[--s->open_count];
+                break;
+            }
+        }
+    }
+    pthread_mutex_unlock(&sr->lock);
+    pthread_mutex_unlock(&s->lock);
+}
+
+/*
+ * Functionality: Steps one room owned or stolen by w, retiring it if it has emptied.
+ */
+static void service_room(Worker *w, ServerRoom *sr, long tick) {
+    if (run_room(w, sr, tick)) retire_room(w->server, sr);
+}
+
+/*
+ * Functionality: Detaches a room's broadcaster, disconnecting its spectators, and returns
+ * it to the pool. Call with the server and the room locked.
+ */
+static void release_broadcast(ServerRoom *sr) {
+    if (!sr->broadcast) return;
+    spectate_reset(&sr->broadcast->spectators);
+    sr->broadcast->room = NULL;
+    sr->broadcast = NULL;
+}
+
+/*
+ * Functionality: Starts w's tick `tick`: drops retired rooms from its list (returning them
+ * and any broadcaster to the slab) and marks every remaining room as still to step.
+ */
+static void begin_tick(Worker *w, long tick) {
+    Server *s = w->server;
+    ServerRoom *retired[64];
+    int n = 0;
+
+    pthread_mutex_lock(&w->lock);
+    w->tick = tick;
+    for (int i = 0; i < w->count && n < 64;) {
+        // Retired rooms are never stepped again, so reading the flag unlocked here is
+        // only ever late, not wrong: the room is released next tick instead
+        if (__atomic_load_n(&w->owned[i]->retired, __ATOMIC_ACQUIRE)) {
+            retired[n++] = w->owned[i];
+            w->owned[i] = w->owned[--w->count];
+        } else {
+            i++;
+        }
+    }
+    w->head = 0;
+    w->tail = w->count;
+    pthread_mutex_unlock(&w->lock);
+
+    if (n == 0) return;
+    pthread_mutex_lock(&s->lock);
+    for (int i = 0; i < n; i++) {
+        pthread_mutex_lock(&retired[i]->lock);
+        release_broadcast(retired[i]);
+        pthread_mutex_unlock(&retired[i]->lock);
+        s->free_slots[s->free_count++] = retired[i]->slot;
+    }
+    pthread_mutex_unlock(&s->lock);
+}
+
+/*
+ * Functionality: Takes the next unstepped room from w's own list. Returns NULL when done.
+ */
+static ServerRoom *take_own(Worker *w) {
+    ServerRoom *sr = NULL;
+    pthread_mutex_lock(&w->lock);
+    if (w->head < w->tail) sr = w->owned[--w->tail];
+    pthread_mutex_unlock(&w->lock);
+    return sr;
+}
+
+/*
+ * Functionality: Steals an unstepped room from the worker with the most left. The room moves
+ * to w's list for good when the victim owns more than one room more than w, so load
+ * evens out; otherwise w only steps it this once. Workers do not run their ticks in
+ * lockstep, so *tick is raised to the victim's tick if that is later: the victim counts
+ * the room as stepped to it. Returns NULL if every worker is done.
+ */
+static ServerRoom *steal(Worker *w, long *tick) {
+    Server *s = w->server;
+    Worker *victim = NULL;
+    int most = 0;
+    for (int i = 1; i < s->worker_count; i++) {
+        Worker *v = &s->workers[(w->index + i) % s->worker_count];
+        pthread_mutex_lock(&v->lock);
+        int left = v->tail - v->head;
+        pthread_mutex_unlock(&v->lock);
+        if (left > most) {
+            most = left;
+            victim = v;
+        }
+    }
+    if (!victim) return NULL;
+
+    pthread_mutex_lock(&w->lock);
+    int own = w->count;
+    pthread_mutex_unlock(&w->lock);
+
+    ServerRoom *sr = NULL;
+    bool move = false;
+    pthread_mutex_lock(&victim->lock);
+    if (victim->head < victim->tail) {
+        sr = victim->owned[victim->head];
+        if (victim->tick > *tick) *tick = victim->tick;
+        move = victim->count > own + 1;
+        if (move) {
+            // Refill the hole from the end of the unstepped range, and that from the end
+            // of the list, so both ranges stay contiguous
+            victim->owned[victim->head] = victim->owned[victim->tail - 1];
+            victim->owned[victim->tail - 1] = victim->owned[victim->count - 1];
+            victim->tail--;
+            victim->count--;
+        } else {
+            victim->head++; // Stays with the victim, counted as stepped
+        }
+    }
+    pthread_mutex_unlock(&victim->lock);
+    if (!sr) return NULL;
+
+    if (move) {
+        // Appended past w's own tail, so it counts as already stepped this tick
+        pthread_mutex_lock(&w->lock);
+        w->owned[w->count++] = sr;
+        pthread_mutex_unlock(&w->lock);
+        w->moved++;
+    }
+    w->steals++;
+    return sr;
+}
+
+/*
+ * Functionality: Worker thread: once per tick, steps its own rooms and then helps the
+ * others until no room is left unstepped.
+ */
+static void *worker_main(void *arg) {
+    Worker *w = (Worker *)arg;
+    Server *s = w->server;
+    long mark = alloc_mark(); // Rooms, buffers and packets all exist before workers start
+
+    for (long tick = 1; __atomic_load_n(&s->running, __ATOMIC_ACQUIRE); tick++) {
+        long long due = s->start_ns + tick * s->tick_ns;
+        struct timespec ts = { (time_t)(due / 1000000000LL), (long)(due % 1000000000LL) };
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+        }
+        long now = current_tick(s);
+        if (now > tick) tick = now; // Fell behind: rooms catch up and the loop resyncs
+
+        begin_tick(w, tick);
+        ServerRoom *sr;
+        while ((sr = take_own(w)) != NULL) {
+            service_room(w, sr, tick);
+        }
+        long due_tick = tick;
+        while ((sr = steal(w, &due_tick)) != NULL) {
+            service_room(w, sr, due_tick); // Skipped if the room is already that far on
+            due_tick = tick;
+        }
+        alloc_check(mark, "snake_server worker");
+    }
+    return NULL;
+}
+
+/*
+ * Functionality: Opens a room from the slab and hands it to the worker owning the fewest.
+ * Call with the server locked. Returns NULL when the slab is exhausted.
+ */
+static ServerRoom *open_room(Server *s) {
+    if (s->free_count == 0) return NULL;
+    ServerRoom *sr = &s->slots[s->free_slots[--s->free_count]];
+    sr->seed = s->seed + s->rooms_opened++;
+    room_reset(&sr->room, sr->seed);
+    sr->players = 0;
+    sr->epoch = current_tick(s);
+    __atomic_store_n(&sr->retired, false, __ATOMIC_RELEASE);
+    s->open[s->open_count++] = sr;
+
+    Worker *best = NULL;
+    int fewest = 0;
+    for (int i = 0; i < s->worker_count; i++) {
+        Worker *w = &s->workers[i];
+        pthread_mutex_lock(&w->lock);
+        if (!best || w->count < fewest) {
+            best = w;
+            fewest = w->count;
+        }
+        pthread_mutex_unlock(&w->lock);
+    }
+    // Past the owner's tail: first stepped on its next tick
+    pthread_mutex_lock(&best->lock);
+    best->owned[best->count++] = sr;
+    pthread_mutex_unlock(&best->lock);
+    return sr;
+}
+
+/*
+ * Functionality: Seats a new connection in the newest open room with a free seat, opening
+ * a room if needed. Returns its client slot, or NULL if every room is full.
+ */
+static Client *seat_player(Server *s, int fd) {
+    Client *c = NULL;
+    pthread_mutex_lock(&s->lock);
+    ServerRoom *sr = NULL;
+    for (int i = s->open_count - 1; i >= 0 && !sr; i--) {
+        if (s->open[i]->players < s->max_players) sr = s->open[i];
+    }
+    if (!sr) sr = open_room(s);
+    if (sr) {
+        pthread_mutex_lock(&sr->lock);
+        int id = room_join(&sr->room);
+        c = &sr->clients[id];
+        c->fd = fd;
+        c->id = id;
+        c->welcomed = c->want_write = c->closing = false;
+        c->out_len = 0;
+        sr->players++;
+        pthread_mutex_unlock(&sr->lock);
+    }
+    pthread_mutex_unlock(&s->lock);
+    return c;
+}
+
+/*
+ * Functionality: Accepts every pending connection and seats it. Connections beyond the
+ * server's capacity are closed straight away.
+ */
+static void on_accept(Server *s) {
+    for (;;) {
+        int fd = accept4(s->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return;
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one)); // One packet per tick
+
+        Client *c = seat_player(s, fd);
+        struct epoll_event ev = { .events = EPOLLIN, .data.ptr = c };
+        if (!c) {
+            close(fd);
+        } else if (epoll_ctl(s->epoll_fd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            ServerRoom *sr = (ServerRoom *)c->owner;
+            pthread_mutex_lock(&sr->lock);
+            drop_client(sr, c);
+            pthread_mutex_unlock(&sr->lock);
+        }
+    }
+}
+
+/*
+ * Functionality: Finds a broadcaster for a room: a free one from the pool, else one whose
+ * room nobody watches any more. Call with the server locked (and not the room). Returns
+ * NULL if every one is in use.
+ */
+static Broadcast *take_broadcast(Server *s) {
+    for (int i = 0; i < SPECTATED_ROOMS; i++) {
+        if (!s->broadcasts[i].room) return &s->broadcasts[i];
+    }
+    for (int i = 0; i < SPECTATED_ROOMS; i++) {
+        Broadcast *b = &s->broadcasts[i];
+        ServerRoom *sr = b->room;
+        pthread_mutex_lock(&sr->lock);
+        bool idle = spectate_idle(&b->spectators);
+        if (idle) release_broadcast(sr);
+        pthread_mutex_unlock(&sr->lock);
+        if (idle) return b;
+    }
+    return NULL;
+}
+
+/*
+ * Functionality: Accepts every pending spectator and has it watch the room with the most
+ * players. Spectators beyond capacity, or with no room to watch, are closed straight away.
+ */
+static void on_spectator(Server *s) {
+    for (;;) {
+        int fd = accept4(s->spectator_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return;
+
+        bool added = false;
+        pthread_mutex_lock(&s->lock);
+        ServerRoom *best = NULL;
+        for (int i = 0; i < s->open_count; i++) {
+            // players only changes on this thread, so it can be read unlocked
+            if (!best || s->open[i]->players > best->players) best = s->open[i];
+        }
+        Broadcast *b = best && !best->broadcast ? take_broadcast(s) : NULL;
+        if (best) {
+            pthread_mutex_lock(&best->lock);
+            if (b) {
+                b->room = best;
+                best->broadcast = b;
+            }
+            if (best->broadcast) added = spectate_add(&best->broadcast->spectators, fd);
+            pthread_mutex_unlock(&best->lock);
+        }
+        pthread_mutex_unlock(&s->lock);
+        if (!added) close(fd);
+    }
+}
+
+/*
+ * Functionality: Handles readiness on a client socket: applies turn keys, flushes pending
+ * output, and drops the client on EOF, error or a worker's shutdown.
+ */
+static void on_client(Server *s, Client *c, uint32_t events) {
+    ServerRoom *sr = (ServerRoom *)c->owner;
+    uint8_t buf[256];
+    pthread_mutex_lock(&sr->lock);
+    bool drop = c->fd < 0 || (events & (EPOLLERR | EPOLLHUP)) != 0;
+    while (!drop && (events & EPOLLIN)) {
+        ssize_t n = recv(c->fd, buf, sizeof(buf), 0);
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            drop = true;
+            break;
+        }
+        Direction dir;
+        for (ssize_t i = 0; i < n; i++) {
+            if (net_key_direction(buf[i], &dir)) room_turn(&sr->room, c->id, dir);
+        }
+    }
+    if (!drop && (events & EPOLLOUT)) drop = !net_flush(c, s->epoll_fd);
+    if (drop) drop_client(sr, c);
+    pthread_mutex_unlock(&sr->lock);
+}
+
+/*
+ * Functionality: Builds the slab: max_rooms rooms with their clients and output buffers.
+ * Returns false if out of memory.
+ */
+static bool build_slab(Server *s, int max_rooms, int pit_height, int pit_width) {
+    s->slots = (ServerRoom *)calloc(max_rooms, sizeof(ServerRoom));
+    s->free_slots = (int *)malloc(max_rooms * sizeof(int));
+    s->open = (ServerRoom **)malloc(max_rooms * sizeof(ServerRoom *));
+    if (!s->slots || !s->free_slots || !s->open) return false;
+
+    for (int i = 0; i < max_rooms; i++) {
+        ServerRoom *sr = &s->slots[i];
+        if (!room_init(&sr->room, pit_height, pit_width, s->max_players, s->seed)) return false;
+        s->slot_count++;
+        pthread_mutex_init(&sr->lock, NULL);
+        sr->slot = i;
+
+        size_t buffer = arena_round(CLIENT_BACKLOG + net_welcome_bound(&sr->room));
+        if (!arena_init(&sr->arena, arena_round(s->max_players * sizeof(Client)) +
+                                        s->max_players * buffer)) {
+            return false;
+        }
+        sr->clients = (Client *)arena_alloc(&sr->arena, s->max_players * sizeof(Client));
+        for (int id = 0; id < s->max_players; id++) {
+            Client *c = &sr->clients[id];
+            c->fd = -1;
+            c->out = (uint8_t *)arena_alloc(&sr->arena, buffer);
+            c->out_cap = buffer;
+            c->owner = sr;
+        }
+        s->free_slots[s->free_count++] = max_rooms - 1 - i; // Lowest slots first
+    }
+    return true;
+}
+
+/*
+ * Functionality: Builds the broadcasters spectators borrow and opens their listening
+ * socket. Returns false if out of memory or the port cannot be opened.
+ */
+static bool open_spectators(Server *s, int port, int pit_height, int pit_width) {
+    s->broadcasts = (Broadcast *)calloc(SPECTATED_ROOMS, sizeof(Broadcast));
+    if (!s->broadcasts) return false;
+    for (int i = 0; i < SPECTATED_ROOMS; i++) {
+        Broadcast *b = &s->broadcasts[i];
+        if (!ansi_open(&b->screen, -1, SPECTATOR_ROWS, SPECTATOR_COLS, pit_height, pit_width) ||
+            !spectate_init(&b->spectators, ROOM_SPECTATORS, b->screen.out_cap)) {
+            return false;
+        }
+    }
+    s->spectator_fd = spectate_listen(port);
+    return s->spectator_fd >= 0;
+}
+
+/*
+ * Functionality: Sets up the slab, the workers' lists, the listening sockets, the signal fd
+ * and the epoll set; workers are started by server_run(). Spectators are only listened
+ * for with a spectator_port above 0. Returns false with a message on stderr on failure.
+ */
+static bool server_init(Server *s, int port, int pit_height, int pit_width, int max_players,
+                        int max_rooms, int workers, long tick_ms, uint64_t seed,
+                        int spectator_port) {
+    memset(s, 0, sizeof(*s));
+    s->listen_fd = s->signal_fd = s->epoll_fd = s->spectator_fd = -1;
+    pthread_mutex_init(&s->lock, NULL);
+    s->max_players = max_players;
+    s->seed = seed;
+    s->tick_ns = tick_ms * 1000000LL;
+    s->running = 1;
+
+    if (max_players < 1 || max_players > ROOM_MAX_SNAKES || max_rooms < 1 ||
+        !build_slab(s, max_rooms, pit_height, pit_width)) {
+        fprintf(stderr, "Cannot reserve %d rooms of %dx%d for %d players each\n", max_rooms,
+                pit_height, pit_width, max_players);
+        return false;
+    }
+
+    s->workers = (Worker *)calloc(workers, sizeof(Worker));
+    if (!s->workers) return false;
+    s->worker_count = workers;
+    for (int i = 0; i < workers; i++) {
+        Worker *w = &s->workers[i];
+        w->server = s;
+        w->index = i;
+        pthread_mutex_init(&w->lock, NULL);
+        w->owned = (ServerRoom **)malloc(max_rooms * sizeof(ServerRoom *));
+        w->packet = (uint8_t *)malloc(net_tick_bound(&s->slots[0].room));
+        if (!w->owned || !w->packet) {
+            fprintf(stderr, "Out of memory\n");
+            return false;
+        }
+    }
+
+    s->listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    int one = 1;
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_port = htons((uint16_t)port),
+                                .sin_addr.s_addr = htonl(INADDR_ANY) };
+    if (s->listen_fd < 0 ||
+        setsockopt(s->listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) != 0 ||
+        bind(s->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        listen(s->listen_fd, SOMAXCONN) != 0) {
+        perror("listen");
+        return false;
+    }
+
+    // SIGINT/SIGTERM arrive through the epoll loop; blocked before any worker starts so
+    // every thread inherits the mask
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &mask, NULL);
+    s->signal_fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+
+    s->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    struct epoll_event listen_ev = { .events = EPOLLIN, .data.ptr = &listen_tag };
+    struct epoll_event signal_ev = { .events = EPOLLIN, .data.ptr = &signal_tag };
+    if (s->signal_fd < 0 || s->epoll_fd < 0 ||
+        epoll_ctl(s->epoll_fd, EPOLL_CTL_ADD, s->listen_fd, &listen_ev) != 0 ||
+        epoll_ctl(s->epoll_fd, EPOLL_CTL_ADD, s->signal_fd, &signal_ev) != 0) {
+        perror("epoll");
+        return false;
+    }
+
+    if (spectator_port > 0) {
+        struct epoll_event spectator_ev = { .events = EPOLLIN, .data.ptr = &spectator_tag };
+        if (!open_spectators(s, spectator_port, pit_height, pit_width) ||
+            epoll_ctl(s->epoll_fd, EPOLL_CTL_ADD, s->spectator_fd, &spectator_ev) != 0) {
+            fprintf(stderr, "Cannot listen for spectators on port %d\n", spectator_port);
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * Functionality: Starts the workers and runs the IO loop until SIGINT or SIGTERM, then
+ * stops the workers.
+ */
+static void server_run(Server *s) {
+    s->start_ns = now_ns();
+    int started = 0;
+    while (started < s->worker_count &&
+           pthread_create(&s->workers[started].thread, NULL, worker_main, &s->workers[started]) == 0) {
+        started++;
+    }
+
+    struct epoll_event events[MAX_EPOLL_EVENTS];
+    while (started > 0 && __atomic_load_n(&s->running, __ATOMIC_ACQUIRE)) {
+        int n = epoll_wait(s->epoll_fd, events, MAX_EPOLL_EVENTS, -1);
+        if (n < 0 && errno != EINTR) {
+            perror("epoll_wait");
+            break;
+        }
+        for (int i = 0; i < n; i++) {
+            void *tag = events[i].data.ptr;
+            if (tag == &listen_tag) {
+                on_accept(s);
+            } else if (tag == &spectator_tag) {
+                on_spectator(s);
+            } else if (tag == &signal_tag) {
+                __atomic_store_n(&s->running, 0, __ATOMIC_RELEASE);
+            } else {
+                on_client(s, (Client *)tag, events[i].events);
+            }
+        }
+    }
+
+    __atomic_store_n(&s->running, 0, __ATOMIC_RELEASE);
+    for (int i = 0; i < started; i++) {
+        pthread_join(s->workers[i].thread, NULL);
+    }
+}
+
+/*
+ * Functionality: Closes every client, spectator and socket and releases the slab, the
+ * broadcasters and the workers.
+ */
+static void server_free(Server *s) {
+    for (int i = 0; s->broadcasts && i < SPECTATED_ROOMS; i++) {
+        spectate_free(&s->broadcasts[i].spectators);
+        ansi_close(&s->broadcasts[i].screen);
+    }
+    free(s->broadcasts);
+    for (int i = 0; i < s->slot_count; i++) {
+        ServerRoom *sr = &s->slots[i];
+        for (int id = 0; sr->clients && id < s->max_players; id++) {
+            drop_client(sr, &sr->clients[id]);
+        }
+        arena_free(&sr->arena);
+        room_free(&sr->room);
+        pthread_mutex_destroy(&sr->lock);
+    }
+    for (int i = 0; s->workers && i < s->worker_count; i++) {
+        free(s->workers[i].owned);
+        free(s->workers[i].packet);
+        pthread_mutex_destroy(&s->workers[i].lock);
+    }
+    free(s->workers);
+    free(s->slots);
+    free(s->free_slots);
+    free(s->open);
+    if (s->listen_fd >= 0) close(s->listen_fd);
+    if (s->signal_fd >= 0) close(s->signal_fd);
+    if (s->epoll_fd >= 0) close(s->epoll_fd);
+    if (s->spectator_fd >= 0) close(s->spectator_fd);
+    pthread_mutex_destroy(&s->lock);
+}
+
+/*
+ * Functionality: Prints usage to stderr.
+ */
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [-p port] [-s HxW] [-n max_players] [-r max_rooms] [-j workers] "
+                    "[-t tick_ms] [-S seed] [-w spectator_port] [-o results_file]\n", prog);
+}
+
+int main(int argc, char **argv) {
+    int port = DEFAULT_PORT;
+    int pit_height = 40, pit_width = 80;
+    int max_players = 16;
+    int max_rooms = 4096;
+    int workers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    long tick_ms = DEFAULT_TICK_MS;
+    uint64_t seed = 1;
+    int spectator_port = 0;
+    const char *results_path = NULL;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "p:s:n:r:j:t:S:w:o:")) != -1) {
+        switch (opt) {
+            case 'p':
+                port = atoi(optarg);
+                break;
+            case 's':
+                if (!parse_pit_size(optarg, &pit_height, &pit_width)) {
+                    usage(argv[0]);
+                    return 1;
+                }
+                break;
+            case 'n':
+                max_players = atoi(optarg);
+                break;
+            case 'r':
+                max_rooms = atoi(optarg);
+                break;
+            case 'j':
+                workers = atoi(optarg);
+                break;
+            case 't':
+                tick_ms = atol(optarg);
+                break;
+            case 'S':
+                seed = strtoull(optarg, NULL, 10);
+                break;
+            case 'w':
+                spectator_port = atoi(optarg);
+                break;
+            case 'o':
+                results_path = optarg;
+                break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+    if (tick_ms < 1) tick_ms = 1;
+    if (workers < 1) workers = 1;
+
+    Server server;
+    if (!server_init(&server, port, pit_height, pit_width, max_players, max_rooms, workers,
+                     tick_ms, seed, spectator_port)) {
+        server_free(&server);
+        return 1;
+    }
+    ResultLog results;
+    if (results_path) {
+        if (!results_open(&results, results_path)) {
+            fprintf(stderr, "Cannot append results to %s\n", results_path);
+            server_free(&server);
+            return 1;
+        }
+        server.results = &results;
+    }
+    printf("snake_server: port %d, %d rooms of %dx%d for %d players, %d workers, %ld ms ticks\n",
+           port, max_rooms, pit_height, pit_width, max_players, workers, tick_ms);
+    fflush(stdout);
+    server_run(&server);
+    bool logged = !server.results || results_close(server.results);
+
+    for (int i = 0; i < server.worker_count; i++) {
+        printf("worker %d: rooms=%d room_ticks=%ld steals=%ld moved=%ld\n", i, server.workers[i].count,
+               server.workers[i].steps, server.workers[i].steals, server.workers[i].moved);
+    }
+    server_free(&server);
+    return logged ? 0 : 1;
+}
@@ -0,0 +1,401 @@
+#define _POSIX_C_SOURCE 200809L // clock_gettime, getopt
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "alloc.h"
+#include "game.h"
+#include "ai.h"
+#include "batch.h"
+#include "results.h"
+
+/*
+ * Batch simulator: plays many independent games across a pool of worker
+ * threads and reports aggregate throughput. Each worker owns its GameState
+ * (body ring, grid, RNG) outright; the only shared data is the counter used
+ * to hand out game numbers and the read-only options.
+ *
+ * With -b N each worker steps N games at once through a structure-of-arrays
+ * GameBatch, so the head/wall/food tests vectorize across games.
+ *
+ * With -a lookahead every game in play has its own Lookahead, searching -k
+ * plies deep on -J threads of its own, within -B microseconds a move if set.
+ *
+ * With -o every finished game's result is appended to a results log (see
+ * results.h), written by a thread of its own so workers never wait on disk.
+ *
+ * Usage: snake_sim [-n games] [-j threads] [-s HxW] [-l length] [-m max_ticks] [-S seed]
+ *                  [-b lanes] [-a greedy|bfs|cycle|lookahead] [-k depth] [-J search_threads]
+ *                  [-B budget_us] [-o results_file]
+ */
+
+// Options shared read-only by every worker
+typedef struct {
+    long games;        // Total games to play
+    int threads;       // Worker threads
+    int pit_height;
+    int pit_width;
+    int target_length; // Length that wins (0 = half perimeter)
+    long max_ticks;    // Per-game cap so a looping bot cannot stall the run
+    uint64_t seed;     // Game i is seeded with seed + i
+    int lanes;         // Games stepped together per worker (0 = one at a time)
+    Policy policy;     // Autopilot driving every game
+    CycleTable cycle;  // Built once at startup for POLICY_CYCLE
+    int search_depth;  // POLICY_LOOKAHEAD settings, see lookahead_init()
+    int search_threads;
+    long search_budget_us;
+    ResultLog *results; // Per-game log, NULL without -o
+} SimOptions;
+
+// Per-worker totals, padded so workers never share a cache line
+typedef struct {
+    long games;
+    long ticks;
+    long wins;
+    long long length_sum;
+    long searches;     // Lookahead moves picked and their total completed depth
+    long depth_sum;
+    char pad[64];
+} WorkerStats;
+
+typedef struct {
+    const SimOptions *opts;
+    long *next_game;   // Shared work counter
+    WorkerStats stats;
+} Worker;
+
+/*
+ * Functionality: Returns the monotonic clock in seconds.
+ */
+static double now_sec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+ * Functionality: Adds a finished game to the worker's totals and to the results log, if any.
+ */
+static void record_game(Worker *w, const GameState *g) {
+    w->stats.games++;
+    w->stats.ticks += g->ticks;
+    w->stats.wins += g->victory;
+    w->stats.length_sum += g->snake.length;
+    if (!w->opts->results) return;
+    GameResult r = {
+        .seed = g->seed,
+        .ticks = g->ticks,
+        .length = g->snake.length,
+        .food = g->snake.length - INITIAL_LENGTH,
+        .outcome = g->victory ? RESULT_WIN : g->game_over ? RESULT_LOSS : RESULT_CAPPED,
+    };
+    results_add(w->opts->results, &r);
+}
+
+/*
+ * Functionality: Sets up count lookahead autopilots for the options, exiting on failure.
+ * Returns NULL unless the policy is POLICY_LOOKAHEAD.
+ */
+static Lookahead *make_lookaheads(const SimOptions *opts, int count) {
+    if (opts->policy != POLICY_LOOKAHEAD) return NULL;
+    Lookahead *la = (Lookahead *)calloc(count, sizeof(Lookahead));
+    for (int i = 0; la && i < count; i++) {
+        if (!lookahead_init(&la[i], opts->pit_height, opts->pit_width, opts->search_depth,
+                            opts->search_threads, opts->search_budget_us)) {
+            la = NULL;
+        }
+    }
+    if (!la) {
+        fprintf(stderr, "Cannot set up the lookahead search\n");
+        exit(1);
+    }
+    return la;
+}
+
+/*
+ * Functionality: Adds the search counts of count lookahead autopilots from make_lookaheads()
+ * to w's totals and releases them.
+ */
+static void free_lookaheads(Worker *w, Lookahead *la, int count) {
+    for (int i = 0; la && i < count; i++) {
+        w->stats.searches += la[i].searches;
+        w->stats.depth_sum += la[i].depth_sum;
+        lookahead_free(&la[i]);
+    }
+    free(la);
+}
+
+/*
+ * Functionality: Claims the next game number and starts it in batch lane i. Returns false
+ * once every game has been handed out.
+ */
+static bool claim_lane(Worker *w, GameBatch *b, Pathfinder *pf, int i) {
+    const SimOptions *opts = w->opts;
+    long n = __atomic_fetch_add(w->next_game, 1, __ATOMIC_RELAXED);
+    if (n >= opts->games) return false;
+    if (!batch_reset_game(b, i, opts->seed + (uint64_t)n)) {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+    if (opts->target_length > 0) game_set_target_length(&b->games[i], opts->target_length);
+    pathfinder_reset(&pf[i]);
+    return true;
+}
+
+/*
+ * Functionality: Allocates count pathfinders for the options' pit size, exiting if out of
+ * memory.
+ */
+static Pathfinder *make_pathfinders(const SimOptions *opts, int count) {
+    Pathfinder *pf = (Pathfinder *)calloc(count, sizeof(Pathfinder));
+    for (int i = 0; pf && i < count; i++) {
+        if (!pathfinder_init(&pf[i], opts->pit_height, opts->pit_width)) pf = NULL;
+    }
+    if (!pf) {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+    return pf;
+}
+
+/*
+ * Functionality: Releases count pathfinders from make_pathfinders().
+ */
+static void free_pathfinders(Pathfinder *pf, int count) {
+    for (int i = 0; i < count; i++) {
+        pathfinder_free(&pf[i]);
+    }
+    free(pf);
+}
+
+/*
+ * Functionality: Batched worker body: keeps every lane of a GameBatch busy, refilling a
+ * lane with the next game as soon as its current one ends.
+ */
+static void run_batched(Worker *w) {
+    const SimOptions *opts = w->opts;
+    GameBatch batch;
+    if (!batch_init(&batch, opts->lanes, opts->pit_height, opts->pit_width)) {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+    Pathfinder *pf = make_pathfinders(opts, batch.count);
+    Lookahead *la = make_lookaheads(opts, batch.count);
+
+    int running = 0;
+    for (int i = 0; i < batch.count; i++) {
+        running += claim_lane(w, &batch, pf, i);
+    }
+    long mark = alloc_mark(); // Lanes reuse their game's memory from here on
+
+    while (running > 0) {
+        for (int i = 0; i < batch.count; i++) {
+            if (batch.alive[i]) {
+                batch_turn(&batch, i, policy_direction(opts->policy, &pf[i], &opts->cycle,
+                                                       la ? &la[i] : NULL, &batch.games[i]));
+            }
+        }
+        batch_step(&batch);
+
+        running = 0;
+        for (int i = 0; i < batch.count; i++) {
+            GameState *g = &batch.games[i];
+            if (!g->snake.body) continue; // Lane never started or already retired
+            if (batch.alive[i] && g->ticks < opts->max_ticks) {
+                running++;
+                continue;
+            }
+            record_game(w, g);
+            batch.alive[i] = 0;
+            if (claim_lane(w, &batch, pf, i)) {
+                running++;
+            } else {
+                game_free(g);
+            }
+        }
+        alloc_check(mark, "snake_sim");
+    }
+    free_pathfinders(pf, batch.count);
+    free_lookaheads(w, la, batch.count);
+    batch_free(&batch);
+}
+
+/*
+ * Functionality: Worker thread body: claims game numbers until none are left and plays
+ * each one to completion with its own state.
+ */
+static void *worker_main(void *arg) {
+    Worker *w = (Worker *)arg;
+    const SimOptions *opts = w->opts;
+    GameState game;
+
+    if (opts->lanes > 0) {
+        run_batched(w);
+        return NULL;
+    }
+    Pathfinder *pf = make_pathfinders(opts, 1);
+    Lookahead *la = make_lookaheads(opts, 1);
+    bool started = false;
+    long mark = 0;
+
+    for (;;) {
+        long i = __atomic_fetch_add(w->next_game, 1, __ATOMIC_RELAXED);
+        if (i >= opts->games) break;
+
+        // The first game maps the worker's memory; later ones reuse it
+        if (started) {
+            game_reset(&game, opts->seed + (uint64_t)i);
+        } else if (game_init(&game, opts->pit_height, opts->pit_width, opts->seed + (uint64_t)i)) {
+            started = true;
+            mark = alloc_mark();
+        } else {
+            fprintf(stderr, "Out of memory\n");
+            exit(1);
+        }
+        if (opts->target_length > 0) game_set_target_length(&game, opts->target_length);
+        pathfinder_reset(pf);
+        while (game.ticks < opts->max_ticks &&
+               game_step(&game, policy_direction(opts->policy, pf, &opts->cycle, la, &game))) {
+            alloc_check(mark, "snake_sim");
+        }
+
+        record_game(w, &game);
+    }
+    if (started) game_free(&game);
+    free_pathfinders(pf, 1);
+    free_lookaheads(w, la, 1);
+    return NULL;
+}
+
+/*
+ * Functionality: Prints usage to stderr.
+ */
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [-n games] [-j threads] [-s HxW] [-l length] [-m max_ticks] [-S seed] [-b lanes] [-a greedy|bfs|cycle|lookahead] [-k depth] [-J search_threads] [-B budget_us] [-o results_file]\n", prog);
+}
+
+int main(int argc, char **argv) {
+    SimOptions opts = {
+        .games = 10000,
+        .threads = (int)sysconf(_SC_NPROCESSORS_ONLN),
+        .pit_height = 20,
+        .pit_width = 40,
+        .max_ticks = 100000,
+        .seed = 1,
+        .lanes = 0,
+        .policy = POLICY_GREEDY,
+        .search_depth = LOOKAHEAD_DEFAULT_DEPTH,
+        .search_threads = 1,
+    };
+
+    const char *results_path = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:j:s:l:m:S:b:a:k:J:B:o:")) != -1) {
+        switch (opt) {
+            case 'n':
+                opts.games = atol(optarg);
+                break;
+            case 'j':
+                opts.threads = atoi(optarg);
+                break;
+            case 's':
+                if (!parse_pit_size(optarg, &opts.pit_height, &opts.pit_width)) {
+                    usage(argv[0]);
+                    return 1;
+                }
+                break;
+            case 'l':
+                opts.target_length = atoi(optarg);
+                break;
+            case 'm':
+                opts.max_ticks = atol(optarg);
+                break;
+            case 'S':
+                opts.seed = strtoull(optarg, NULL, 10);
+                break;
+            case 'b':
+                opts.lanes = atoi(optarg);
+                break;
+            case 'a':
+                if (!parse_policy(optarg, &opts.policy)) {
+                    usage(argv[0]);
+                    return 1;
+                }
+                break;
+            case 'k':
+                opts.search_depth = atoi(optarg);
+                break;
+            case 'J':
+                opts.search_threads = atoi(optarg);
+                break;
+            case 'B':
+                opts.search_budget_us = atol(optarg);
+                break;
+            case 'o':
+                results_path = optarg;
+                break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+    if (opts.threads < 1) opts.threads = 1;
+    if (opts.policy == POLICY_CYCLE &&
+        !cycle_table_init(&opts.cycle, opts.pit_height, opts.pit_width, default_cache_dir())) {
+        fprintf(stderr, "No Hamiltonian cycle for a %dx%d pit (one side must be even)\n",
+                opts.pit_height, opts.pit_width);
+        return 1;
+    }
+    ResultLog results;
+    if (results_path) {
+        if (!results_open(&results, results_path)) {
+            fprintf(stderr, "Cannot append results to %s\n", results_path);
+            return 1;
+        }
+        opts.results = &results;
+    }
+
+    Worker *workers = (Worker *)calloc(opts.threads, sizeof(Worker));
+    pthread_t *tids = (pthread_t *)malloc(opts.threads * sizeof(pthread_t));
+    if (!workers || !tids) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    long next_game = 0;
+    double start = now_sec();
+    for (int t = 0; t < opts.threads; t++) {
+        workers[t].opts = &opts;
+        workers[t].next_game = &next_game;
+        pthread_create(&tids[t], NULL, worker_main, &workers[t]);
+    }
+
+    WorkerStats total = {0};
+    for (int t = 0; t < opts.threads; t++) {
+        pthread_join(tids[t], NULL);
+        total.games += workers[t].stats.games;
+        total.ticks += workers[t].stats.ticks;
+        total.wins += workers[t].stats.wins;
+        total.length_sum += workers[t].stats.length_sum;
+        total.searches += workers[t].stats.searches;
+        total.depth_sum += workers[t].stats.depth_sum;
+    }
+    double elapsed = now_sec() - start;
+    bool logged = !opts.results || results_close(opts.results);
+
+    printf("games=%ld threads=%d lanes=%d pit=%dx%d ticks=%ld wins=%ld avg_length=%.2f "
+           "seconds=%.3f ticks_per_sec=%.0f\n",
+           total.games, opts.threads, opts.lanes, opts.pit_height, opts.pit_width, total.ticks, total.wins,
+           total.games ? (double)total.length_sum / total.games : 0.0,
+           elapsed, elapsed > 0 ? total.ticks / elapsed : 0.0);
+    if (total.searches > 0) {
+        printf("search_depth=%.2f\n", (double)total.depth_sum / total.searches);
+    }
+
+    free(workers);
+    free(tids);
+    cycle_table_free(&opts.cycle);
+    return logged ? 0 : 1;
+}
@@ -0,0 +1,228 @@
+#define _DEFAULT_SOURCE // MSG_DONTWAIT
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "spectate.h"
+
+/*
+ * Functionality: Sets up a broadcaster for up to max_watchers watchers of frames up to
+ * frame_cap bytes, reserving every frame and watcher slot up front. Returns false if the
+ * reservation fails.
+ */
+bool spectate_init(Spectate *sp, int max_watchers, size_t frame_cap) {
+    memset(sp, 0, sizeof(*sp));
+    // In-sync watchers share the newest SPECTATE_QUEUE diffs and the keyframes between
+    // them; a skipped one may still be part way through one older frame; and one more is
+    // being published
+    int frame_count = 2 * SPECTATE_QUEUE + max_watchers + 1;
+    size_t reserve = arena_round(frame_count * sizeof(SpectateFrame)) +
+                     arena_round(max_watchers * sizeof(Watcher)) +
+                     frame_count * arena_round(frame_cap);
+    if (max_watchers < 1 || !arena_init(&sp->arena, reserve)) return false;
+
+    sp->frames = (SpectateFrame *)arena_alloc(&sp->arena, frame_count * sizeof(SpectateFrame));
+    sp->watchers = (Watcher *)arena_alloc(&sp->arena, max_watchers * sizeof(Watcher));
+    for (int i = 0; i < frame_count; i++) {
+        sp->frames[i].data = (char *)arena_alloc(&sp->arena, frame_cap);
+    }
+    for (int i = 0; i < max_watchers; i++) {
+        sp->watchers[i].fd = -1;
+    }
+    sp->frame_count = frame_count;
+    sp->frame_cap = frame_cap;
+    sp->max_watchers = max_watchers;
+    sp->since_keyframe = -1;
+    return true;
+}
+
+/*
+ * Functionality: Drops a watcher's queued frames. With keep_partial set, a frame it has
+ * started sending stays, so the watcher's stream is never cut mid-sequence.
+ */
+static void drop_queue(Spectate *sp, Watcher *w, bool keep_partial) {
+    int keep = keep_partial && w->queued > 0 && w->offset > 0 ? 1 : 0;
+    for (int i = keep; i < w->queued; i++) {
+        sp->frames[w->queue[i]].refs--;
+    }
+    w->queued = keep;
+    if (!keep) w->offset = 0;
+}
+
+/*
+ * Functionality: Disconnects a watcher and releases its frames.
+ */
+static void remove_watcher(Spectate *sp, Watcher *w) {
+    close(w->fd);
+    w->fd = -1;
+    drop_queue(sp, w, false);
+    if (w->waiting) sp->waiting_count--;
+    sp->watcher_count--;
+}
+
+/*
+ * Functionality: Disconnects every watcher and forgets the stream, ready for another game.
+ */
+void spectate_reset(Spectate *sp) {
+    for (int i = 0; i < sp->max_watchers; i++) {
+        if (sp->watchers[i].fd >= 0) remove_watcher(sp, &sp->watchers[i]);
+    }
+    sp->since_keyframe = -1;
+}
+
+/*
+ * Functionality: Disconnects every watcher and releases the broadcaster.
+ */
+void spectate_free(Spectate *sp) {
+    if (sp->watchers) spectate_reset(sp);
+    arena_free(&sp->arena);
+    sp->frames = NULL;
+    sp->watchers = NULL;
+}
+
+/*
+ * Functionality: Adds a connected socket as a watcher, made non-blocking. It gets frames
+ * from the next keyframe on. Returns false if every slot is taken (the caller closes fd).
+ */
+bool spectate_add(Spectate *sp, int fd) {
+    for (int i = 0; i < sp->max_watchers; i++) {
+        Watcher *w = &sp->watchers[i];
+        if (w->fd >= 0) continue;
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        w->fd = fd;
+        w->queued = 0;
+        w->offset = 0;
+        w->waiting = true;
+        sp->waiting_count++;
+        sp->watcher_count++;
+        return true;
+    }
+    return false;
+}
+
+/*
+ * Functionality: Opens a non-blocking TCP listening socket for watchers on port. Returns it,
+ * or -1 on failure.
+ */
+int spectate_listen(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    int one = 1;
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_port = htons((uint16_t)port),
+                                .sin_addr.s_addr = htonl(INADDR_ANY) };
+    if (setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) != 0 ||
+        bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, SOMAXCONN) != 0 ||
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/*
+ * Functionality: Accepts every pending connection on listen_fd as a watcher, closing those
+ * beyond capacity.
+ */
+void spectate_accept(Spectate *sp, int listen_fd) {
+    for (;;) {
+        int fd = accept(listen_fd, NULL, NULL);
+        if (fd < 0) return;
+        if (!spectate_add(sp, fd)) close(fd);
+    }
+}
+
+/*
+ * Functionality: Returns true if nobody is watching, so the producer can skip rendering.
+ */
+bool spectate_idle(const Spectate *sp) {
+    return sp->watcher_count == 0;
+}
+
+/*
+ * Functionality: Returns true if a keyframe should follow this tick's diff: someone is
+ * waiting for one and the gap since the last has passed.
+ */
+bool spectate_wants_keyframe(const Spectate *sp) {
+    return sp->waiting_count > 0 &&
+           (sp->since_keyframe < 0 || sp->since_keyframe >= SPECTATE_KEYFRAME_GAP);
+}
+
+/*
+ * Functionality: Takes the frame r has built (see ansi_take_frame()) into a shared buffer.
+ * A diff is queued for every watcher in sync, except that one whose queue is full is
+ * skipped to the next keyframe instead; a keyframe is queued for every waiting watcher,
+ * which is then in sync.
+ */
+void spectate_publish(Spectate *sp, AnsiRenderer *r, bool keyframe) {
+    int index = 0;
+    while (index < sp->frame_count && sp->frames[index].refs > 0) index++;
+    if (index == sp->frame_count) { // Cannot happen with the pool's size; drop the frame
+        r->out_len = 0;
+        return;
+    }
+    SpectateFrame *frame = &sp->frames[index];
+    frame->len = ansi_take_frame(r, frame->data, sp->frame_cap);
+    if (keyframe) {
+        sp->since_keyframe = 0;
+    } else if (sp->since_keyframe >= 0) {
+        sp->since_keyframe++;
+    }
+
+    for (int i = 0; i < sp->max_watchers; i++) {
+        Watcher *w = &sp->watchers[i];
+        if (w->fd < 0 || w->waiting != keyframe) continue;
+        if (keyframe) {
+            w->waiting = false;
+            sp->waiting_count--;
+        } else if (w->queued == SPECTATE_QUEUE) {
+            // Too far behind to catch up frame by frame
+            drop_queue(sp, w, true);
+            w->waiting = true;
+            sp->waiting_count++;
+            sp->skips++;
+            continue;
+        }
+        w->queue[w->queued++] = index;
+        frame->refs++;
+    }
+}
+
+/*
+ * Functionality: Sends every watcher what it has queued, with one non-blocking sendmsg()
+ * each gathering from the shared frames. Watchers whose socket fails are disconnected.
+ */
+void spectate_flush(Spectate *sp) {
+    for (int i = 0; i < sp->max_watchers; i++) {
+        Watcher *w = &sp->watchers[i];
+        if (w->fd < 0 || w->queued == 0) continue;
+
+        struct iovec iov[SPECTATE_QUEUE];
+        for (int k = 0; k < w->queued; k++) {
+            const SpectateFrame *frame = &sp->frames[w->queue[k]];
+            size_t skip = k == 0 ? w->offset : 0;
+            iov[k].iov_base = frame->data + skip;
+            iov[k].iov_len = frame->len - skip;
+        }
+        struct msghdr msg = { .msg_iov = iov, .msg_iovlen = (size_t)w->queued };
+        ssize_t n = sendmsg(w->fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) remove_watcher(sp, w);
+            continue;
+        }
+
+        // Release the frames that went out completely
+        size_t sent = (size_t)n;
+        int done = 0;
+        while (done < w->queued && sent >= iov[done].iov_len) {
+            sent -= iov[done].iov_len;
+            sp->frames[w->queue[done++]].refs--;
+        }
+        memmove(w->queue, w->queue + done, (size_t)(w->queued - done) * sizeof(int));
+        w->queued -= done;
+        w->offset = done > 0 ? sent : w->offset + sent;
+    }
+}
@@ -0,0 +1,74 @@
+#ifndef SPECTATE_H
+#define SPECTATE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "ansi.h"
+#include "arena.h"
+
+/*
+ * Spectator fan-out: one game's ANSI frames (see ansi.h) broadcast to many
+ * watchers over sockets.
+ *
+ * Each tick's frame is rendered once, into a reference-counted buffer from a
+ * fixed pool, and every watcher queues a reference to it rather than a copy.
+ * spectate_flush() then sends each watcher everything it has queued with one
+ * sendmsg() gathering straight from the shared buffers. Frames start with an
+ * absolute cursor move and a full color (ansi_begin_frame()), so any frame
+ * applies to any watcher whose screen matches the one before it, wherever the
+ * last frame left the cursor.
+ *
+ * A watcher that falls SPECTATE_QUEUE frames behind does not hold the game up
+ * or buffer without bound: its backlog is dropped (except the frame it is part
+ * way through, which must finish so no escape sequence is cut) and it gets
+ * nothing more until the next keyframe, a full repaint that brings its screen
+ * back in sync. New watchers start the same way. Keyframes go only to waiting
+ * watchers, rendered after the tick's diff from the same renderer, so both
+ * leave a screen showing the same state; watchers in sync keep getting diffs.
+ * They are rendered only when someone is waiting, at most once per
+ * SPECTATE_KEYFRAME_GAP frames.
+ */
+
+#define SPECTATE_QUEUE 16          // Frames a watcher may have unsent before it skips
+#define SPECTATE_KEYFRAME_GAP 10   // Frames at least between keyframes for waiting watchers
+
+typedef struct {
+    char *data;        // frame_cap bytes in the pool's arena
+    size_t len;
+    int refs;          // Watchers that still have to send it; 0 when free
+} SpectateFrame;
+
+typedef struct {
+    int fd;                        // -1 when the slot is free
+    int queue[SPECTATE_QUEUE];     // Frames to send, oldest first
+    int queued;
+    size_t offset;                 // Bytes of queue[0] already sent
+    bool waiting;                  // Skipping frames until the next keyframe
+} Watcher;
+
+typedef struct {
+    SpectateFrame *frames;   // Enough that a free one always exists when publishing
+    int frame_count;
+    size_t frame_cap;
+    Watcher *watchers;
+    int max_watchers;
+    int watcher_count;
+    int waiting_count;       // Watchers waiting for a keyframe
+    long since_keyframe;     // Frames published since the last keyframe, -1 before any
+    long skips;              // Times a slow watcher was skipped to a keyframe
+    Arena arena;             // Backs the frames and watchers
+} Spectate;
+
+bool spectate_init(Spectate *sp, int max_watchers, size_t frame_cap);
+void spectate_free(Spectate *sp);
+void spectate_reset(Spectate *sp);
+bool spectate_add(Spectate *sp, int fd);
+int spectate_listen(int port);
+void spectate_accept(Spectate *sp, int listen_fd);
+bool spectate_idle(const Spectate *sp);
+bool spectate_wants_keyframe(const Spectate *sp);
+void spectate_publish(Spectate *sp, AnsiRenderer *r, bool keyframe);
+void spectate_flush(Spectate *sp);
+
+#endif
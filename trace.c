@@ -0,0 +1,83 @@
+#define _POSIX_C_SOURCE 200809L // clock_gettime, getpid
+#include "trace.h"
+
+#ifdef SNAKE_TRACE
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+typedef struct {
+    const char *name;    // A string literal, from TRACE_END()
+    long long start_ns;
+    long long end_ns;
+    int tid;
+} TraceSpan;
+
+static TraceSpan spans[TRACE_CAPACITY]; // Untouched pages cost nothing
+static long span_count;                 // Atomic: slots claimed, may pass the capacity
+static int thread_count;                // Atomic: trace thread ids handed out
+static int registered;                  // Atomic: the exit handler is set
+static long long origin_ns;             // Time 0 in the trace: the first span's start
+static __thread int thread_id;          // 0 until the thread's first span
+
+/*
+ * Functionality: Returns the monotonic clock in nanoseconds.
+ */
+long long trace_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/*
+ * Functionality: Writes every recorded span to $SNAKE_TRACE_FILE (default snake_trace.json)
+ * as Chrome trace JSON. Runs at exit, once the threads are done.
+ */
+static void trace_write(void) {
+    const char *path = getenv("SNAKE_TRACE_FILE");
+    if (!path || !*path) path = "snake_trace.json";
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        perror(path);
+        return;
+    }
+    long count = span_count < TRACE_CAPACITY ? span_count : TRACE_CAPACITY;
+    int pid = (int)getpid();
+    fprintf(f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    bool first = true;
+    for (long i = 0; i < count; i++) {
+        const TraceSpan *s = &spans[i];
+        if (!s->name) continue; // Claimed by a thread that never finished writing it
+        fprintf(f, "%s{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%d}\n",
+                first ? "" : ",", s->name, (s->start_ns - origin_ns) / 1e3,
+                (s->end_ns - s->start_ns) / 1e3, pid, s->tid);
+        first = false;
+    }
+    fprintf(f, "],\"otherData\":{\"spans\":%ld,\"dropped\":%ld}}\n", count, span_count - count);
+    fclose(f);
+    fprintf(stderr, "trace: %ld spans (%ld dropped) written to %s\n", count, span_count - count,
+            path);
+}
+
+/*
+ * Functionality: Records a span that started at start_ns (from trace_now()) and ends now.
+ */
+void trace_span(const char *name, long long start_ns) {
+    long long end_ns = trace_now();
+    if (thread_id == 0) {
+        thread_id = __atomic_add_fetch(&thread_count, 1, __ATOMIC_RELAXED);
+        if (__atomic_exchange_n(&registered, 1, __ATOMIC_ACQ_REL) == 0) {
+            origin_ns = start_ns;
+            atexit(trace_write);
+        }
+    }
+    long slot = __atomic_fetch_add(&span_count, 1, __ATOMIC_RELAXED);
+    if (slot >= TRACE_CAPACITY) return;
+    spans[slot].start_ns = start_ns;
+    spans[slot].end_ns = end_ns;
+    spans[slot].tid = thread_id;
+    __atomic_store_n(&spans[slot].name, name, __ATOMIC_RELEASE);
+}
+#endif
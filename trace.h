@@ -0,0 +1,30 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+/*
+ * Trace points for the hot paths: the game step and its parts, and the
+ * interactive game's drawing and terminal updates. Building with
+ * -DSNAKE_TRACE (make TRACE=1, usually with make profile) times every span
+ * between TRACE_BEGIN(name) and TRACE_END(name) in the same block and keeps
+ * it in a fixed in-memory buffer shared by all threads, so tracing never
+ * allocates or does IO while the game runs. When the process exits the spans
+ * are written as Chrome trace JSON ("X" events, one track per thread) to
+ * $SNAKE_TRACE_FILE, default snake_trace.json, for chrome://tracing or
+ * ui.perfetto.dev. Once the buffer is full later spans are dropped and
+ * counted. In normal builds the macros compile to nothing.
+ */
+
+#define TRACE_CAPACITY (1 << 20) // Spans kept per run
+
+#ifdef SNAKE_TRACE
+long long trace_now(void);
+void trace_span(const char *name, long long start_ns);
+
+#define TRACE_BEGIN(name) long long trace_start_##name = trace_now()
+#define TRACE_END(name) trace_span(#name, trace_start_##name)
+#else
+#define TRACE_BEGIN(name) ((void)0)
+#define TRACE_END(name) ((void)0)
+#endif
+
+#endif